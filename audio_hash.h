@@ -0,0 +1,20 @@
+#ifndef AUDIO_HASH_H
+#define AUDIO_HASH_H
+
+#include "types.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Running CRC-32 (IEEE) and byte count of an audio payload */
+typedef struct _AudioHash
+{
+    uint32_t crc;
+    uint64_t bytes;
+} AudioHash;
+
+void audio_hash_init (AudioHash *h);
+void audio_hash_update (AudioHash *h, const void *buf, size_t len);
+uint32_t audio_hash_value (const AudioHash *h);
+int audio_hash_equal (const AudioHash *a, const AudioHash *b);
+
+#endif
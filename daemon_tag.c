@@ -0,0 +1,667 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "daemon_tag.h"
+#include "view_tag.h"
+#include "edit_tag.h"
+#include "query_tag.h"
+#include "mp3_io.h"
+#include "frame_registry.h"
+#include "str_hash.h"
+#include "types.h"
+
+#define DAEMON_MAX_WORKERS 16
+#define DAEMON_MAX_FIELDS 64
+#define DAEMON_MAX_LINE (64 * 1024)
+/* Pause after accept() runs out of descriptors, instead of spinning on it */
+#define DAEMON_ACCEPT_BACKOFF_MS 100
+/* Direct-mapped cache of parsed tags: bounded memory, O(1) lookup */
+#define DAEMON_CACHE_SLOTS 16384
+
+typedef struct
+{
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    TagInfo info;
+} CacheEntry;
+
+static CacheEntry cache[DAEMON_CACHE_SLOTS];
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Edits are read-modify-write of the whole tag: two edits of the same file
+   must not interleave or one would be lost.  Striped by path so edits of
+   different files run in parallel */
+#define DAEMON_EDIT_STRIPES 64
+static pthread_mutex_t edit_locks[DAEMON_EDIT_STRIPES];
+static pthread_once_t edit_locks_once = PTHREAD_ONCE_INIT;
+static int listen_fd = -1;
+
+const char *daemon_default_socket_path(void)
+{
+    static char path[PATH_MAX];
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    if (!dir || dir[0] != '/')
+        dir = DAEMON_FALLBACK_DIR;
+    if (snprintf(path, sizeof(path), "%s/%s", dir, DAEMON_SOCKET_NAME) >= (int)sizeof(path))
+        snprintf(path, sizeof(path), "%s/%s", DAEMON_FALLBACK_DIR, DAEMON_SOCKET_NAME);
+    return path;
+}
+
+const char *daemon_socket_path(void)
+{
+    const char *env = getenv(DAEMON_SOCKET_ENV);
+    if (env)
+        return env[0] ? env : NULL;
+    return daemon_default_socket_path();
+}
+
+static void set_timeout(int fd, int opt, long ms)
+{
+    struct timeval tv = {ms / 1000, (ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, opt, &tv, sizeof(tv));
+}
+
+/* Whether the other end of a connected socket runs as our user */
+static int peer_is_us(int fd)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+}
+
+static Status copy_tag_info(TagInfo *dst, const TagInfo *src)
+{
+    *dst = *src;
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        dst->field[i] = NULL;
+        if (src->field[i] && !(dst->field[i] = strdup(src->field[i])))
+        {
+            free_tag_info(dst);
+            return p_failure;
+        }
+    }
+    return p_success;
+}
+
+static int same_stamp(const CacheEntry *e, const struct stat *st)
+{
+    return e->dev == st->st_dev && e->ino == st->st_ino && e->size == st->st_size &&
+           e->mtime.tv_sec == st->st_mtim.tv_sec && e->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* Parsed tag for path, served from the cache unless the file changed since it was parsed */
+static Status cached_tag_info(const char *path, TagInfo *out, int *open_failed)
+{
+    struct stat st;
+    *open_failed = 0;
+    if (stat(path, &st) != 0)
+    {
+        *open_failed = 1;
+        return p_failure;
+    }
+
+    CacheEntry *e = &cache[str_hash(path) & (DAEMON_CACHE_SLOTS - 1)];
+    Status hit = p_failure;
+    pthread_mutex_lock(&cache_lock);
+    if (e->path && strcmp(e->path, path) == 0 && same_stamp(e, &st))
+        hit = copy_tag_info(out, &e->info);
+    pthread_mutex_unlock(&cache_lock);
+    if (hit == p_success)
+        return p_success;
+
+    /* miss or stale: parse outside the lock; the stamp was taken first so a
+       concurrent change is caught on the next request */
+    TagInfo fresh;
+    if (load_tag_info(path, &fresh) != p_success)
+        return p_failure;
+    if (copy_tag_info(out, &fresh) != p_success)
+    {
+        free_tag_info(&fresh);
+        return p_failure;
+    }
+
+    char *key = strdup(path);
+    pthread_mutex_lock(&cache_lock);
+    free(e->path);
+    free_tag_info(&e->info);
+    e->path = key;
+    e->dev = st.st_dev;
+    e->ino = st.st_ino;
+    e->size = st.st_size;
+    e->mtime = st.st_mtim;
+    e->info = fresh;
+    if (!key)
+        free_tag_info(&e->info);
+    pthread_mutex_unlock(&cache_lock);
+    return p_success;
+}
+
+static void init_edit_locks(void)
+{
+    for (int i = 0; i < DAEMON_EDIT_STRIPES; ++i)
+        pthread_mutex_init(&edit_locks[i], NULL);
+}
+
+static pthread_mutex_t *edit_lock_for(const char *path)
+{
+    pthread_once(&edit_locks_once, init_edit_locks);
+    return &edit_locks[str_hash(path) % DAEMON_EDIT_STRIPES];
+}
+
+static void cache_invalidate(const char *path)
+{
+    CacheEntry *e = &cache[str_hash(path) & (DAEMON_CACHE_SLOTS - 1)];
+    pthread_mutex_lock(&cache_lock);
+    if (e->path && strcmp(e->path, path) == 0)
+    {
+        free(e->path);
+        e->path = NULL;
+        free_tag_info(&e->info);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+/* Write text with protocol separators replaced */
+static void put_clean(FILE *out, const char *s)
+{
+    for (; s && *s; ++s)
+        fputc((*s == '\t' || *s == '\n' || *s == '\r') ? ' ' : *s, out);
+}
+
+static void reply_err(FILE *out, const char *msg)
+{
+    fprintf(out, "ERR\t");
+    put_clean(out, msg);
+    fprintf(out, "\n");
+}
+
+static void handle_view(FILE *out, char **fields, int nf)
+{
+    if (nf != 2)
+    {
+        reply_err(out, "Bad VIEW request.");
+        return;
+    }
+    TagInfo info;
+    int open_failed;
+    char msg[PATH_MAX + 64];
+    if (cached_tag_info(fields[1], &info, &open_failed) != p_success)
+    {
+        if (open_failed)
+            snprintf(msg, sizeof(msg), "Unable to Open the %s file.", fields[1]);
+        else
+            snprintf(msg, sizeof(msg), "The file Signature is not matching with that of a '.mp3' file.");
+        reply_err(out, msg);
+        return;
+    }
+    fprintf(out, "VERSION\t%u.%u\n", info.ver_major, info.ver_rev);
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        fprintf(out, "FIELD\t%s\t", frame_types[i].id);
+        put_clean(out, info.field[i]);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "OK\n");
+    free_tag_info(&info);
+}
+
+static void handle_edit(FILE *out, char **fields, int nf)
+{
+    if (nf < 4 || nf > 8)
+    {
+        reply_err(out, "Bad EDIT request.");
+        return;
+    }
+    /* rebuild the argv layout edit_tag() expects */
+    char *eargv[12] = {"mp3_tag_reader", "-e"};
+    for (int i = 1; i < nf; ++i)
+        eargv[i + 1] = fields[i];
+    eargv[nf + 1] = NULL;
+
+    TagData td = {0};
+    pthread_mutex_t *lock = edit_lock_for(fields[3]);
+    pthread_mutex_lock(lock);
+    Status st = read_and_validate_mp3_file_args(eargv, &td);
+    if (st == p_success)
+        st = edit_tag(eargv, &td);
+    cache_invalidate(fields[3]);
+    pthread_mutex_unlock(lock);
+    fflush(stdout);
+
+    if (st == p_success)
+        fprintf(out, "OK\n");
+    else
+        reply_err(out, "Edit failed, see daemon log.");
+}
+
+static void handle_query(FILE *out, char **fields, int nf)
+{
+    if (nf < 2)
+    {
+        reply_err(out, "Bad QUERY request.");
+        return;
+    }
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *ms = open_memstream(&buf, &len);
+    if (!ms)
+    {
+        reply_err(out, "Out of memory.");
+        return;
+    }
+    Status st = run_query(fields[1], fields + 2, ms);
+    fclose(ms);
+
+    char *save = NULL;
+    for (char *line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+        fprintf(out, "DATA\t%s\n", line);
+    free(buf);
+    if (st == p_success)
+        fprintf(out, "OK\n");
+    else
+        reply_err(out, "Query failed.");
+}
+
+/* Serve requests on one connection until the client hangs up */
+static void serve_connection(int fd)
+{
+    int wfd = dup(fd);
+    FILE *in = fdopen(fd, "r");
+    FILE *out = (wfd >= 0) ? fdopen(wfd, "w") : NULL;
+    if (!in || !out)
+    {
+        if (in)
+            fclose(in);
+        else
+            close(fd);
+        if (out)
+            fclose(out);
+        else if (wfd >= 0)
+            close(wfd);
+        return;
+    }
+
+    /* an idle or stuck client must not hold a worker forever */
+    set_timeout(fd, SO_RCVTIMEO, DAEMON_IDLE_SECS * 1000L);
+    set_timeout(wfd, SO_SNDTIMEO, DAEMON_IDLE_SECS * 1000L);
+    fprintf(out, "READY\n");
+    if (fflush(out) != 0)
+    {
+        fclose(in);
+        fclose(out);
+        return;
+    }
+
+    /* fixed buffer: a client cannot make the daemon allocate more than this */
+    char *line = malloc(DAEMON_MAX_LINE + 1);
+    while (line && fgets(line, DAEMON_MAX_LINE + 1, in))
+    {
+        size_t n = strlen(line);
+        if (n == 0 || line[n - 1] != '\n')
+        {
+            if (n == DAEMON_MAX_LINE)
+                reply_err(out, "Request too long.");
+            break; /* otherwise the client went away mid-request: never act on half a line */
+        }
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+            line[--n] = '\0';
+
+        char *fields[DAEMON_MAX_FIELDS + 1];
+        int nf = 0;
+        char *rest = line;
+        char *tok;
+        while (nf < DAEMON_MAX_FIELDS && (tok = strsep(&rest, "\t")) != NULL)
+            fields[nf++] = tok;
+        fields[nf] = NULL;
+
+        if (strcmp(fields[0], "VIEW") == 0)
+            handle_view(out, fields, nf);
+        else if (strcmp(fields[0], "EDIT") == 0)
+            handle_edit(out, fields, nf);
+        else if (strcmp(fields[0], "QUERY") == 0)
+            handle_query(out, fields, nf);
+        else
+            reply_err(out, "Unsupported request.");
+
+        if (fflush(out) != 0)
+            break;
+    }
+    free(line);
+    fclose(in);
+    fclose(out);
+}
+
+static void *worker_main(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            {
+                /* the connection stays queued; its client times out and runs locally */
+                usleep(DAEMON_ACCEPT_BACKOFF_MS * 1000);
+                continue;
+            }
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        if (!peer_is_us(fd))
+        {
+            close(fd);
+            continue;
+        }
+        serve_connection(fd);
+    }
+    return NULL;
+}
+
+static int fill_addr(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+static int connect_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    if (!path || fill_addr(&addr, path) != 0)
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    /* a socket at a shared path may belong to someone else: never trust it */
+    if (!peer_is_us(fd))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* CLI: -d [socket_path] -- runs in the foreground until SIGINT/SIGTERM */
+Status run_daemon(char *argv[])
+{
+    const char *path = argv[2] ? argv[2] : daemon_socket_path();
+    if (!path)
+        path = daemon_default_socket_path();
+    struct sockaddr_un addr;
+    if (fill_addr(&addr, path) != 0)
+    {
+        printf("❌ERROR: Socket path %s is too long.\n", path);
+        return p_failure;
+    }
+
+    int probe = connect_socket(path);
+    if (probe >= 0)
+    {
+        close(probe);
+        printf("❌ERROR: A daemon is already listening on %s.\n", path);
+        return p_failure;
+    }
+    /* a file truncated under a MAP_SHARED mapping raises SIGBUS, which would
+       take the whole daemon (and every client) down: read with pread only */
+    mp3io_disable_mmap();
+
+    /* stale socket from a previous run; never remove anything else */
+    struct stat sb;
+    if (lstat(path, &sb) == 0)
+    {
+        if (!S_ISSOCK(sb.st_mode))
+        {
+            printf("❌ERROR: %s exists and is not a socket.\n", path);
+            return p_failure;
+        }
+        unlink(path);
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+    {
+        printf("❌ERROR: Unable to create socket.\n");
+        return p_failure;
+    }
+    mode_t old_mask = umask(077); /* only the owner may talk to the daemon */
+    int rc = bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (rc != 0 || listen(listen_fd, 128) != 0)
+    {
+        printf("❌ERROR: Unable to listen on %s.\n", path);
+        close(listen_fd);
+        return p_failure;
+    }
+
+    /* workers inherit the blocked set; the main thread waits for the stop signal */
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t stop;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop, NULL);
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nworkers = (ncpu < 2) ? 2 : (ncpu > DAEMON_MAX_WORKERS ? DAEMON_MAX_WORKERS : (int)ncpu);
+    pthread_t workers[DAEMON_MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < nworkers; ++i)
+    {
+        if (pthread_create(&workers[i], NULL, worker_main, NULL) == 0)
+            started++;
+    }
+    if (started == 0)
+    {
+        printf("❌ERROR: Unable to start worker threads.\n");
+        close(listen_fd);
+        unlink(path);
+        return p_failure;
+    }
+    printf("INFO: Daemon listening on %s with %d workers.\n", path, started);
+    fflush(stdout);
+
+    int sig;
+    sigwait(&stop, &sig);
+    unlink(path);
+    printf("INFO: Daemon stopped.\n");
+    return p_success;
+}
+
+/* Client side */
+
+static int has_separators(const char *s)
+{
+    return s && strpbrk(s, "\t\n\r") != NULL;
+}
+
+Status forward_to_daemon(char *argv[], OperationType op, Status *result)
+{
+    const char *sock = daemon_socket_path();
+    if (!sock || argv[2] == NULL)
+        return p_failure;
+
+    /* the daemon has its own working directory: send absolute paths */
+    int path_arg = (op == p_edit) ? 4 : 2;
+    if (op == p_edit && (argv[3] == NULL || argv[4] == NULL))
+        return p_failure;
+    if (op != p_view && op != p_edit && op != p_query)
+        return p_failure;
+    for (int i = 2; argv[i] != NULL; ++i)
+    {
+        if (has_separators(argv[i]))
+            return p_failure;
+    }
+    char abs_path[PATH_MAX];
+    if (!realpath(argv[path_arg], abs_path) || has_separators(abs_path))
+        return p_failure;
+
+    if (op == p_edit && frame_type_by_flag(argv[2]) < 0)
+        return p_failure;
+
+    char *req = NULL;
+    size_t req_len = 0;
+    FILE *rs = open_memstream(&req, &req_len);
+    if (!rs)
+        return p_failure;
+    if (op == p_view)
+        fprintf(rs, "VIEW\t%s\n", abs_path);
+    else if (op == p_edit)
+    {
+        fprintf(rs, "EDIT\t%s\t%s\t%s", argv[2], argv[3], abs_path);
+        for (int i = 5; argv[i] != NULL; ++i)
+        {
+            /* the journal may not exist yet, so anchor it to our cwd by hand */
+            if (strcmp(argv[i - 1], "--journal") == 0 && argv[i][0] != '/')
+            {
+                char cwd[PATH_MAX];
+                if (!getcwd(cwd, sizeof(cwd)))
+                {
+                    fclose(rs);
+                    free(req);
+                    return p_failure;
+                }
+                fprintf(rs, "\t%s/%s", cwd, argv[i]);
+            }
+            else
+                fprintf(rs, "\t%s", argv[i]);
+        }
+        fprintf(rs, "\n");
+    }
+    else
+    {
+        fprintf(rs, "QUERY\t%s", abs_path);
+        for (int i = 3; argv[i] != NULL; ++i)
+            fprintf(rs, "\t%s", argv[i]);
+        fprintf(rs, "\n");
+    }
+    fclose(rs);
+
+    int fd = connect_socket(sock);
+    if (fd < 0)
+    {
+        free(req);
+        return p_failure;
+    }
+    FILE *io = fdopen(fd, "r");
+    if (!io)
+    {
+        close(fd);
+        free(req);
+        return p_failure;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+
+    /* no greeting in time: every worker is busy, nothing was sent yet, run locally */
+    set_timeout(fd, SO_RCVTIMEO, DAEMON_READY_TIMEOUT_MS);
+    n = getline(&line, &cap, io);
+    if (n <= 0 || strncmp(line, "READY", 5) != 0)
+    {
+        free(line);
+        free(req);
+        fclose(io);
+        return p_failure;
+    }
+
+    /* an edit may be in progress on the daemon side, so only view/query give up */
+    set_timeout(fd, SO_RCVTIMEO, (op == p_edit) ? 0 : DAEMON_REPLY_TIMEOUT_SECS * 1000L);
+    ssize_t sent = send(fd, req, req_len, MSG_NOSIGNAL);
+    free(req);
+    if (sent != (ssize_t)req_len)
+    {
+        free(line);
+        fclose(io);
+        return p_failure;
+    }
+
+    TagInfo info;
+    memset(&info, 0, sizeof(info));
+    char *data = NULL;
+    size_t data_len = 0;
+    FILE *ms = open_memstream(&data, &data_len);
+    int done = 0;
+    Status st = p_failure;
+    char *err = NULL;
+    while (ms && !done && (n = getline(&line, &cap, io)) > 0)
+    {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+            line[--n] = '\0';
+        if (strcmp(line, "OK") == 0)
+        {
+            st = p_success;
+            done = 1;
+        }
+        else if (strncmp(line, "ERR\t", 4) == 0)
+        {
+            err = strdup(line + 4);
+            done = 1;
+        }
+        else if (strncmp(line, "DATA\t", 5) == 0)
+            fprintf(ms, "%s\n", line + 5);
+        else if (strncmp(line, "VERSION\t", 8) == 0)
+        {
+            unsigned maj = 0, rev = 0;
+            sscanf(line + 8, "%u.%u", &maj, &rev);
+            info.ver_major = (unsigned char)maj;
+            info.ver_rev = (unsigned char)rev;
+        }
+        else if (strncmp(line, "FIELD\t", 6) == 0 && n >= 11 && line[10] == '\t')
+        {
+            int type = frame_type_by_id(pack_frame_id(line + 6));
+            if (type >= 0 && !info.field[type])
+                info.field[type] = strdup(line + 11);
+        }
+    }
+    free(line);
+    fclose(io);
+    if (ms)
+        fclose(ms);
+
+    if (!done && op != p_edit)
+    {
+        /* daemon went away mid-request: nothing was printed yet, run locally */
+        free_tag_info(&info);
+        free(data);
+        return p_failure;
+    }
+
+    if (op == p_view && st == p_success)
+        print_tag_info(&info);
+    else if (op == p_edit && st == p_success)
+        printf("%s Modification - Done✅\n", frame_types[frame_type_by_flag(argv[2])].name);
+    if (data && data_len)
+        fwrite(data, 1, data_len, stdout);
+    if (st != p_success && op != p_query)
+        printf("❌ERROR: %s\n", err ? err : "Lost connection to the daemon.");
+
+    free_tag_info(&info);
+    free(data);
+    free(err);
+    *result = st;
+    return p_success;
+}
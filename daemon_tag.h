@@ -0,0 +1,49 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "types.h"
+
+/*
+ * Local daemon ("-d") serving view/edit/query over a Unix domain socket.
+ *
+ * On accept the daemon greets with "READY"; a client that does not see it
+ * within DAEMON_READY_TIMEOUT_MS (all workers busy) runs the request
+ * locally instead.  Then a line protocol, one request per line, fields
+ * separated by TAB:
+ *   VIEW   <abs_path>
+ *   EDIT   <modifier> <value> <abs_path> [--verify] [--journal <abs_file>] [--compress]
+ *   QUERY  <abs_index_path> [args...]
+ * Replies are zero or more lines
+ *   VERSION <major.rev>             (VIEW)
+ *   FIELD   <frame_id> <text>       (VIEW, one per registered frame)
+ *   DATA    <line>                  (QUERY output)
+ * terminated by "OK" or "ERR <message>".  A connection may carry any
+ * number of requests; the daemon drops it after DAEMON_IDLE_SECS without
+ * one.  VIEW/QUERY replies that take longer than DAEMON_REPLY_TIMEOUT_SECS
+ * are abandoned and run locally; EDIT waits for its reply.
+ *
+ * The daemon always reads files with pread: $MP3_TAG_IO=mmap is ignored,
+ * since a file truncated while mapped would kill it with SIGBUS.
+ */
+
+#define DAEMON_SOCKET_ENV "MP3_TAG_SOCKET"
+#define DAEMON_READY_TIMEOUT_MS 1000
+#define DAEMON_REPLY_TIMEOUT_SECS 30
+#define DAEMON_IDLE_SECS 30
+
+/* Default socket: $XDG_RUNTIME_DIR/<name> (private per user), else /tmp/<name> */
+#define DAEMON_SOCKET_NAME "mp3_tag_reader.sock"
+#define DAEMON_FALLBACK_DIR "/tmp"
+
+/* Socket path from $MP3_TAG_SOCKET or the default; NULL when forwarding is disabled (empty variable) */
+const char *daemon_socket_path (void);
+const char *daemon_default_socket_path (void);
+
+Status run_daemon (char* argv[]);
+
+/* Try to hand a -v/-e/-q request to a running daemon.  Returns p_failure if
+   no daemon answered (caller runs locally), otherwise p_success with the
+   outcome of the request in *result */
+Status forward_to_daemon (char* argv[], OperationType op, Status *result);
+
+#endif
@@ -1,40 +1,36 @@
 #define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "edit_tag.h"
+#include "mp3_io.h"
 #include "view_tag.h" 
+#include "frame_registry.h"
+#include "frame_codec.h"
+#include "audio_hash.h"
+#include "journal_tag.h"
 #include "types.h"   /* for ID3 tag structures and helpers */
 
 
-/* helpers (some duplicate small helpers from mp3view.c) */
-static uint syncsafe_to_int(const unsigned char s[4])
+/* Re-read the audio region of a freshly written file and compare it with the hash taken during the copy */
+static Status verify_audio_copy(const char *path, off_t audio_offset, const AudioHash *expected)
 {
-    return ((s[0] & 0x7F) << 21) |
-           ((s[1] & 0x7F) << 14) |
-           ((s[2] & 0x7F) << 7) |
-           ((s[3] & 0x7F));
-}
-
-static void int_to_syncsafe(uint val, unsigned char out[4])
-{
-    out[0] = (val >> 21) & 0x7F;
-    out[1] = (val >> 14) & 0x7F;
-    out[2] = (val >> 7) & 0x7F;
-    out[3] = val & 0x7F;
-}
-
-static uint be32_to_uint(const unsigned char b[4])
-{
-    return ((uint)b[0] << 24) | ((uint)b[1] << 16) | ((uint)b[2] << 8) | (uint)b[3];
-}
-
-static void uint_to_be32(uint v, unsigned char out[4])
-{
-    out[0] = (v >> 24) & 0xFF;
-    out[1] = (v >> 16) & 0xFF;
-    out[2] = (v >> 8) & 0xFF;
-    out[3] = v & 0xFF;
+    Mp3IO io;
+    if (mp3io_open(&io, path, O_RDONLY) != p_success)
+        return p_failure;
+    AudioHash readback;
+    audio_hash_init(&readback);
+    Status st = p_failure;
+    if (mp3io_copy_to_end(&io, audio_offset, NULL, 0, &readback) == p_success &&
+        audio_hash_equal(&readback, expected))
+        st = p_success;
+    mp3io_close(&io);
+    return st;
 }
 
 /* Validate args and fill TagData */
@@ -46,27 +42,20 @@ Status read_and_validate_mp3_file_args(char *argv[], TagData *mp3tagData)
     {
         printf("INFO: For Editing the Tags -> ./mp3_tag_reader -e <modifier> \"New_Value\" <file_name.mp3>\n");
         printf("INFO: Modifier Functions:\n");
-        printf("-t\tModify Title Tag\n-A\tModify Artist Tag\n-a\tModify Album Tag\n-y\tModify Year Tag\n-G\tModify Content Type Tag\n-c\tModify Comments Tag\n");
+        for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+            printf("%s\tModify %s Tag\n", frame_types[i].flag, frame_types[i].name);
         return p_failure;
     }
 
-    if ((strncmp(argv[2], "-t", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "TIT2", 5);
-    else if ((strncmp(argv[2], "-A", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "TPE1", 5);
-    else if ((strncmp(argv[2], "-a", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "TALB", 5);
-    else if ((strncmp(argv[2], "-y", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "TYER", 5);
-    else if ((strncmp(argv[2], "-G", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "TCON", 5);
-    else if ((strncmp(argv[2], "-c", 2) == 0))
-        strncpy(mp3tagData->frame_Id, "COMM", 5);
-    else
+    int type = frame_type_by_flag(argv[2]);
+    if (type < 0)
     {
         printf("❌ERROR: Unsupported Modifier.\n");
         return p_failure;
     }
+    mp3tagData->frame_type = type;
+    memcpy(mp3tagData->frame_Id, frame_types[type].id, 4);
+    mp3tagData->frame_Id[4] = '\0';
 
     if (argv[3] == NULL)
     {
@@ -88,30 +77,63 @@ Status read_and_validate_mp3_file_args(char *argv[], TagData *mp3tagData)
         printf("➡️INFO: For Editing the Tags -> ./mp3_tag_reader -e <modifier> \"New_Value\" <file_name.mp3>\n");
         return p_failure;
     }
+    /* trailing options */
+    for (int i = 5; argv[i] != NULL; ++i)
+    {
+        if (strcmp(argv[i], "--verify") == 0)
+            mp3tagData->verify_audio = 1;
+        else if (strcmp(argv[i], "--compress") == 0)
+            mp3tagData->compress_frames = 1;
+        else if (strcmp(argv[i], "--journal") == 0 && argv[i + 1] != NULL)
+            mp3tagData->journal_path = argv[++i];
+        else
+        {
+            printf("❌ERROR: Unsupported option %s.\n", argv[i]);
+            return p_failure;
+        }
+    }
     /* check that file exists and is ID3 */
-    FILE *f = fopen(argv[4], "rb");
-    if (!f)
+    Mp3IO io;
+    if (mp3io_open(&io, argv[4], O_RDONLY) != p_success)
     {
         printf("❌ERROR: Unable to Open the %s file.\n", argv[4]);
         return p_failure;
     }
     char sig[4] = {0};
-    if (fread(sig, 1, 3, f) != 3 || strncmp(sig, "ID3", 3) != 0)
+    if (mp3io_read_full(&io, sig, 3, 0) != p_success || strncmp(sig, "ID3", 3) != 0)
     {
         printf("❌ERROR: The file Signature is not matching with that of a '.mp3' file.\n");
-        fclose(f);
+        mp3io_close(&io);
         return p_failure;
     }
-    fclose(f);
+    mp3io_close(&io);
     return p_success;
 }
 
 /* Rebuild tag frames in memory and write back to file (safe rewrite) */
 Status edit_tag(char *argv[], TagData *mp3tagData)
 {
+    typedef struct
+    {
+        char id[5];
+        uint size;
+        unsigned char flags[2];
+        unsigned char *data;
+    } TempFrame;
+
     const char *filename = argv[4];
-    FILE *f = fopen(filename, "rb");
-    if (!f)
+    Status st = p_failure;
+    unsigned char *tag_block = NULL;
+    TempFrame *frames = NULL;
+    int fcount = 0, fcap = 0;
+    unsigned char *new_frame_data = NULL;
+    unsigned char *tag_out = NULL;
+    char temp_path[PATH_MAX] = "";   /* set while a temp file exists */
+    Mp3IO temp;
+    temp.fd = -1;
+
+    Mp3IO src;
+    if (mp3io_open(&src, filename, O_RDONLY) != p_success)
     {
         printf("❌ERROR: Unable to open file.\n");
         return p_failure;
@@ -119,46 +141,24 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
 
     /* Read old header */
     unsigned char header[10];
-    if (fread(header, 1, 10, f) != 10)
-    {
-        fclose(f);
-        return p_failure;
-    }
+    if (mp3io_read_full(&src, header, 10, 0) != p_success)
+        goto out;
     if (strncmp((char *)header, "ID3", 3) != 0)
-    {
-        fclose(f);
-        return p_failure;
-    }
+        goto out;
 
     unsigned char size_bytes[4];
     memcpy(size_bytes, header + 6, 4);
     uint old_tag_size = syncsafe_to_int(size_bytes);
+    if ((off_t)old_tag_size > src.size - 10)
+        goto out;
 
     /* read old tag block */
-    unsigned char *tag_block = malloc(old_tag_size);
-    if (!tag_block)
-    {
-        fclose(f);
-        return p_failure;
-    }
-    if (fread(tag_block, 1, old_tag_size, f) != old_tag_size)
-    {
-        free(tag_block);
-        fclose(f);
-        return p_failure;
-    }
+    tag_block = malloc(old_tag_size ? old_tag_size : 1);
+    if (!tag_block || mp3io_read_full(&src, tag_block, old_tag_size, 10) != p_success)
+        goto out;
 
     /* parse old frames into array (like mp3view does) */
     size_t offset = 0;
-    typedef struct
-    {
-        char id[5];
-        uint size;
-        unsigned char flags[2];
-        unsigned char *data;
-    } TempFrame;
-    TempFrame *frames = NULL;
-    int fcount = 0, fcap = 0;
     while (offset + 10 <= old_tag_size)
     {
         unsigned char *p = tag_block + offset;
@@ -167,14 +167,15 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
         TempFrame tf = {0};
         memcpy(tf.id, p, 4);
         tf.id[4] = '\0';
-        tf.size = be32_to_uint(p + 4);
+        tf.size = frame_size_from_bytes(header[3], p + 4);
         tf.flags[0] = p[8];
         tf.flags[1] = p[9];
         if (tf.size > old_tag_size - offset - 10)
             break;
-        tf.data = malloc(tf.size);
+        /* out of memory must not silently drop the remaining frames */
+        tf.data = malloc(tf.size ? tf.size : 1);
         if (!tf.data)
-            break;
+            goto out;
         if (tf.size > 0)
             memcpy(tf.data, p + 10, tf.size);
         if (fcount >= fcap)
@@ -184,7 +185,7 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
             if (!tmp)
             {
                 free(tf.data);
-                break;
+                goto out;
             }
             frames = tmp;
         }
@@ -207,9 +208,8 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
        For text frames: content = [encoding byte=0] + value bytes
        For COMM: content = [encoding=0] + language(3) + shortdesc('\0') + comment text
     */
-    unsigned char *new_frame_data = NULL;
     uint new_frame_size = 0;
-    if (strncmp(mp3tagData->frame_Id, "COMM", 4) == 0)
+    if (frame_types[mp3tagData->frame_type].decoder == FRAME_DECODE_COMMENT)
     {
         /* language 'eng', shortdesc empty */
         const char *lang = "eng";
@@ -218,8 +218,7 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
         new_frame_size = 1 + 3 + 1 + comment_len; /* enc + lang + empty desc + comment */
         new_frame_data = malloc(new_frame_size);
         if (!new_frame_data)
-        { /* cleanup and exit */
-        }
+            goto out;
         new_frame_data[0] = 0; /* encoding ISO-8859-1 */
         memcpy(new_frame_data + 1, lang, 3);
         new_frame_data[4] = 0; /* empty shortdesc terminated */
@@ -232,8 +231,7 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
         new_frame_size = 1 + vlen;
         new_frame_data = malloc(new_frame_size);
         if (!new_frame_data)
-        { /* cleanup later */
-        }
+            goto out;
         new_frame_data[0] = 0; /* encoding ISO-8859-1 */
         memcpy(new_frame_data + 1, val, vlen);
     }
@@ -243,7 +241,10 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
     {
         free(frames[target_index].data);
         frames[target_index].data = new_frame_data;
+        new_frame_data = NULL; /* owned by frames now */
         frames[target_index].size = new_frame_size;
+        /* new payload is stored plain: drop compression/encryption/grouping, keep status flags */
+        frames[target_index].flags[1] = 0;
     }
     else
     {
@@ -253,18 +254,31 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
             fcap = fcap ? fcap * 2 : 16;
             TempFrame *tmp = realloc(frames, fcap * sizeof(TempFrame));
             if (!tmp)
-            { /* cleanup */
-            }
+                goto out;
             frames = tmp;
         }
         TempFrame tf = {0};
         strncpy(tf.id, mp3tagData->frame_Id, 4);
         tf.data = new_frame_data;
+        new_frame_data = NULL;
         tf.size = new_frame_size;
         tf.flags[0] = tf.flags[1] = 0;
         frames[fcount++] = tf;
     }
 
+    /* --compress: deflate every large frame that is still stored plain;
+       other frames (already compressed, encrypted, ...) pass through untouched */
+    if (mp3tagData->compress_frames)
+    {
+        int packed = 0;
+        for (int i = 0; i < fcount; ++i)
+        {
+            if (frame_compress(header[3], frames[i].flags, &frames[i].data, &frames[i].size) == p_success)
+                packed++;
+        }
+        printf("INFO: Compressed %d frame(s).\n", packed);
+    }
+
     /* Rebuild new tag bytes from frames */
     /* Calculate total frames bytes */
     uint new_frames_bytes = 0;
@@ -276,119 +290,107 @@ Status edit_tag(char *argv[], TagData *mp3tagData)
     /* New tag size (excluding header) */
     uint new_tag_size = new_frames_bytes;
 
-    /* Create new file temp, write header with updated syncsafe size and write frames, then copy audio data */
-    FILE *temp = fopen("temp.mp3", "wb");
-    if (!temp)
+    /* Serialise header (old one with the size updated) and frames into one buffer */
+    tag_out = malloc(10 + (size_t)new_tag_size);
+    if (!tag_out)
+        goto out;
+    memcpy(tag_out, header, 10);
+    int_to_syncsafe(new_tag_size, tag_out + 6);
+    size_t pos = 10;
+    for (int i = 0; i < fcount; ++i)
     {
-        printf("❌ERROR: Unable to open temp file.\n"); /* cleanup */
-        fclose(f);
-        return p_failure;
+        memcpy(tag_out + pos, frames[i].id, 4);
+        frame_size_to_bytes(header[3], frames[i].size, tag_out + pos + 4);
+        memcpy(tag_out + pos + 8, frames[i].flags, 2);
+        if (frames[i].size > 0)
+            memcpy(tag_out + pos + 10, frames[i].data, frames[i].size);
+        pos += 10 + frames[i].size;
     }
 
-    /* write header same as old but update size syncsafe */
-    unsigned char new_header[10];
-    memcpy(new_header, header, 10);
-    unsigned char new_size_bytes[4];
-    int_to_syncsafe(new_tag_size, new_size_bytes);
-    memcpy(new_header + 6, new_size_bytes, 4);
-    if (fwrite(new_header, 1, 10, temp) != 10)
+    /* Create a unique temp file next to the original (same filesystem, so
+       the final rename is atomic and concurrent edits never share it), write
+       the tag, then copy audio data behind it */
+    struct stat sb;
+    int tfd = -1;
+    if (snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", filename) < (int)sizeof(temp_path) &&
+        fstat(src.fd, &sb) == 0)
+        tfd = mkostemp(temp_path, O_CLOEXEC);
+    if (tfd < 0)
+        temp_path[0] = '\0';
+    if (tfd < 0 || mp3io_open_fd(&temp, tfd) != p_success || fchmod(temp.fd, sb.st_mode & 07777) != 0)
     {
-        fclose(f);
-        fclose(temp);
-        return p_failure;
+        printf("❌ERROR: Unable to open temp file.\n");
+        goto out;
     }
+    Status wst = mp3io_write_full(&temp, tag_out, pos, 0);
 
-    /* write frames */
-    for (int i = 0; i < fcount; ++i)
-    {
-        /* frame id 4 bytes */
-        if (fwrite(frames[i].id, 1, 4, temp) != 4)
-        {
-            fclose(f);
-            fclose(temp);
-            return p_failure;
-        }
-        /* frame size big-endian 4 bytes */
-        unsigned char size_be[4];
-        uint_to_be32(frames[i].size, size_be);
-        if (fwrite(size_be, 1, 4, temp) != 4)
-        {
-            fclose(f);
-            fclose(temp);
-            return p_failure;
-        }
-        /* flags 2 bytes */
-        if (fwrite(frames[i].flags, 1, 2, temp) != 2)
-        {
-            fclose(f);
-            fclose(temp);
-            return p_failure;
-        }
-        /* data */
-        if (frames[i].size > 0)
-        {
-            if (fwrite(frames[i].data, 1, frames[i].size, temp) != frames[i].size)
-            {
-                fclose(f);
-                fclose(temp);
-                return p_failure;
-            }
-        }
-    }
+    /* Old padding is dropped; audio starts right after the old tag area (off_t: may be past 2 GB) */
+    off_t audio_offset = 10 + (off_t)old_tag_size;
+
+    /* copy rest of audio, hashing it on the way when verification is on */
+    AudioHash copied;
+    audio_hash_init(&copied);
+    int hash_audio = mp3tagData->verify_audio || mp3tagData->journal_path;
+    if (wst == p_success)
+        wst = mp3io_copy_to_end(&src, audio_offset, &temp, 10 + (off_t)new_tag_size, hash_audio ? &copied : NULL);
 
-    /* After frames, there may be padding in old tag area; we will ignore old padding and now copy the rest of file (audio) */
-    /* The original file pointer f currently sits after reading header+old tag. We'll seek to header+old_tag_size+10 */
-    long audio_offset = 10 + old_tag_size;
-    if (fseek(f, audio_offset, SEEK_SET) != 0)
+    mp3io_close(&src);
+    /* the data must be on disk before the rename can make it the only copy */
+    if (wst == p_success && fsync(temp.fd) != 0)
+        wst = p_failure;
+    if (mp3io_close(&temp) != p_success || wst != p_success)
     {
-        fclose(f);
-        fclose(temp);
-        return p_failure;
+        printf("❌ERROR: Unable to write temp file.\n");
+        goto out;
     }
 
-    /* copy rest of audio */
-    char buf[4096];
-    size_t rn;
-    while ((rn = fread(buf, 1, sizeof(buf), f)) > 0)
+    /* never replace the original unless the audio came through intact */
+    if (mp3tagData->verify_audio)
     {
-        if (fwrite(buf, 1, rn, temp) != rn)
+        if (verify_audio_copy(temp_path, 10 + (off_t)new_tag_size, &copied) != p_success)
         {
-            fclose(f);
-            fclose(temp);
-            return p_failure;
+            printf("❌ERROR: Audio verification failed. Original file left untouched.\n");
+            goto out;
         }
+        printf("INFO: Audio verified (%llu bytes, CRC-32 %08x).\n",
+               (unsigned long long)copied.bytes, audio_hash_value(&copied));
     }
 
-    fclose(f);
-    fclose(temp);
-
-    /* overwrite original file with temp (simple remove+rename) */
-    if (remove(filename) != 0)
+    /* journal the original tag before it is gone; no journal entry, no edit */
+    if (mp3tagData->journal_path)
     {
-        /* fallback: try to open original for write and write temp into it */
-        printf("⚠️WARNING: unable to remove original file. Attempting overwrite.\n");
+        char abs_path[PATH_MAX];
+        if (!realpath(filename, abs_path) ||
+            journal_append(mp3tagData->journal_path, abs_path, header, tag_block, old_tag_size, &copied) != p_success)
+        {
+            printf("❌ERROR: Unable to write journal %s. Original file left untouched.\n", mp3tagData->journal_path);
+            goto out;
+        }
     }
-    if (rename("temp.mp3", filename) != 0)
+
+    /* rename over the original: it is either fully replaced or left untouched */
+    if (rename(temp_path, filename) != 0)
     {
         printf("❌ERROR: Unable to replace original file with temp file.\n");
-        return p_failure;
+        goto out;
     }
+    temp_path[0] = '\0';
 
-    /* Free frames */
+    /* Print success message like sample */
+    printf("%s Modification - Done✅\n", frame_types[mp3tagData->frame_type].name);
+    st = p_success;
+
+out:
+    /* single exit: whatever step failed, nothing is leaked and no temp file is left behind */
+    mp3io_close(&temp);
+    if (temp_path[0])
+        unlink(temp_path);
+    mp3io_close(&src);
     for (int i = 0; i < fcount; ++i)
-    {
         free(frames[i].data);
-    }
     free(frames);
+    free(new_frame_data);
+    free(tag_out);
     free(tag_block);
-
-    /* Print success message like sample */
-    if (strncmp(mp3tagData->frame_Id, "TIT2", 4) == 0)
-        printf("Title Modification - Done✅\n");
-    else if (strncmp(mp3tagData->frame_Id, "TPE1", 4) == 0)
-        printf("Artist Modification - Done✅\n");
-    else
-        printf("Modification - Done✅\n");
-
-    return p_success;
+    return st;
 }
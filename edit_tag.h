@@ -7,9 +7,13 @@
 typedef struct _TagData
 {
     FILE* fptr_mp3;
+    int frame_type;          /* index into frame_types[] */
     char frame_Id [5];
     char frame_Id_value [256];
     uint frame_Id_size;
+    int verify_audio;        /* --verify: hash audio while copying and check the temp file */
+    const char *journal_path; /* --journal <file>: record the original tag before replacing the file */
+    int compress_frames;     /* --compress: zlib-compress large plain frames on write */
 } TagData;
 
 /* Function prototypes */
@@ -0,0 +1,416 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "export_tag.h"
+#include "view_tag.h"
+#include "frame_registry.h"
+#include "str_hash.h"
+#include "types.h"
+
+/* Growable byte buffer used while a column is being built */
+typedef struct
+{
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} ByteBuf;
+
+/* A finished column: directory entry plus its payload */
+typedef struct
+{
+    ColDirEntry dir;
+    ByteBuf payload;
+} ColBuf;
+
+/* Dictionary entry while sorting */
+typedef struct
+{
+    const char *str;
+    uint32_t code;
+} DictEntry;
+
+static Status buf_append(ByteBuf *b, const void *src, size_t n)
+{
+    if (b->len + n > b->cap)
+    {
+        size_t ncap = b->cap ? b->cap : 4096;
+        while (ncap < b->len + n)
+            ncap *= 2;
+        unsigned char *tmp = realloc(b->data, ncap);
+        if (!tmp)
+            return p_failure;
+        b->data = tmp;
+        b->cap = ncap;
+    }
+    if (n > 0)
+        memcpy(b->data + b->len, src, n);
+    b->len += n;
+    return p_success;
+}
+
+/* Pad buffer with zero bytes up to the next 8 byte boundary */
+static Status buf_align8(ByteBuf *b)
+{
+    static const unsigned char zeros[8] = {0};
+    size_t pad = (8 - (b->len & 7)) & 7;
+    return buf_append(b, zeros, pad);
+}
+
+static void col_init(ColBuf *col, const char *name, ColKind kind)
+{
+    memset(col, 0, sizeof(*col));
+    /* NUL padded, not terminated: an 8 character name fills the field */
+    memcpy(col->dir.name, name, strnlen(name, sizeof(col->dir.name)));
+    col->dir.kind = kind;
+}
+
+static int dict_entry_cmp(const void *a, const void *b)
+{
+    return strcmp(((const DictEntry *)a)->str, ((const DictEntry *)b)->str);
+}
+
+/* Offsets table + NUL terminated bytes for a list of strings (NULL is stored as "") */
+static Status append_string_table(ByteBuf *b, const char **vals, size_t count)
+{
+    uint64_t off = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (buf_append(b, &off, sizeof(off)) != p_success)
+            return p_failure;
+        off += (vals[i] ? strlen(vals[i]) : 0) + 1;
+    }
+    if (buf_append(b, &off, sizeof(off)) != p_success)
+        return p_failure;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const char *v = vals[i] ? vals[i] : "";
+        if (buf_append(b, v, strlen(v) + 1) != p_success)
+            return p_failure;
+    }
+    return buf_align8(b);
+}
+
+/* vals[i] == NULL marks row i absent in the trailing bitmap */
+static Status build_string_col(ColBuf *col, const char *name, const char **vals, size_t count)
+{
+    col_init(col, name, COL_STRING);
+    if (append_string_table(&col->payload, vals, count) != p_success)
+        return p_failure;
+    for (size_t i = 0; i < count; i += 8)
+    {
+        unsigned char bits = 0;
+        for (size_t j = 0; j < 8 && i + j < count; ++j)
+        {
+            if (!vals[i + j])
+                bits |= 1u << j;
+        }
+        if (buf_append(&col->payload, &bits, 1) != p_success)
+            return p_failure;
+    }
+    return buf_align8(&col->payload);
+}
+
+/* Dictionary-encode a string column; the dictionary is stored sorted and
+   NULL values get COL_DICT_ABSENT instead of an entry */
+static Status build_dict_col(ColBuf *col, const char *name, const char **vals, size_t count)
+{
+    col_init(col, name, COL_DICT);
+
+    size_t slots = 16;
+    while (slots < count * 2)
+        slots *= 2;
+    uint32_t *table = malloc(slots * sizeof(uint32_t)); /* code + 1, 0 = empty */
+    uint32_t *codes = malloc((count ? count : 1) * sizeof(uint32_t));
+    DictEntry *uniq = malloc((count ? count : 1) * sizeof(DictEntry));
+    uint32_t *rank = NULL;
+    const char **sorted = NULL;
+    Status st = p_failure;
+    if (!table || !codes || !uniq)
+        goto out;
+    memset(table, 0, slots * sizeof(uint32_t));
+
+    uint32_t nuniq = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!vals[i])
+        {
+            codes[i] = COL_DICT_ABSENT;
+            continue;
+        }
+        size_t h = str_hash(vals[i]) & (slots - 1);
+        while (table[h] && strcmp(uniq[table[h] - 1].str, vals[i]) != 0)
+            h = (h + 1) & (slots - 1);
+        if (!table[h])
+        {
+            uniq[nuniq].str = vals[i];
+            uniq[nuniq].code = nuniq;
+            table[h] = ++nuniq;
+        }
+        codes[i] = table[h] - 1;
+    }
+
+    /* sort dictionary and remap codes so code order == string order */
+    qsort(uniq, nuniq, sizeof(DictEntry), dict_entry_cmp);
+    rank = malloc((nuniq ? nuniq : 1) * sizeof(uint32_t));
+    sorted = malloc((nuniq ? nuniq : 1) * sizeof(char *));
+    if (!rank || !sorted)
+        goto out;
+    for (uint32_t i = 0; i < nuniq; ++i)
+    {
+        rank[uniq[i].code] = i;
+        sorted[i] = uniq[i].str;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (codes[i] != COL_DICT_ABSENT)
+            codes[i] = rank[codes[i]];
+    }
+
+    col->dir.dict_count = nuniq;
+    if (buf_append(&col->payload, codes, count * sizeof(uint32_t)) != p_success ||
+        buf_align8(&col->payload) != p_success ||
+        append_string_table(&col->payload, sorted, nuniq) != p_success)
+        goto out;
+    st = p_success;
+
+out:
+    free(table);
+    free(codes);
+    free(uniq);
+    free(rank);
+    free(sorted);
+    return st;
+}
+
+static Status build_u32_col(ColBuf *col, const char *name, const uint32_t *vals, size_t count)
+{
+    col_init(col, name, COL_U32);
+    if (buf_append(&col->payload, vals, count * sizeof(uint32_t)) != p_success)
+        return p_failure;
+    return buf_align8(&col->payload);
+}
+
+static Status build_u64_col(ColBuf *col, const char *name, const uint64_t *vals, size_t count)
+{
+    col_init(col, name, COL_U64);
+    return buf_append(&col->payload, vals, count * sizeof(uint64_t));
+}
+
+/* TYER is stored numerically so range filters need no string parsing;
+   a missing or non-numeric year is COL_U32_ABSENT, not 0 */
+static uint32_t parse_year(const char *s)
+{
+    if (!s)
+        return COL_U32_ABSENT;
+    char *end;
+    unsigned long y = strtoul(s, &end, 10);
+    if (end == s || y >= COL_U32_ABSENT)
+        return COL_U32_ABSENT;
+    return (uint32_t)y;
+}
+
+/* Parse and stat one file into a record */
+Status load_tag_record(const char *path, TagRecord *rec)
+{
+    if (!path || !rec)
+        return p_failure;
+    memset(rec, 0, sizeof(*rec));
+
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return p_failure;
+    if (load_tag_info(path, &rec->info) != p_success)
+        return p_failure;
+    rec->path = strdup(path);
+    if (!rec->path)
+    {
+        free_tag_info(&rec->info);
+        return p_failure;
+    }
+    rec->file_size = (uint64_t)st.st_size;
+    rec->mtime_ns = (uint64_t)st.st_mtim.tv_sec * 1000000000u + (uint64_t)st.st_mtim.tv_nsec;
+    return p_success;
+}
+
+Status free_tag_record(TagRecord *rec)
+{
+    if (!rec)
+        return p_failure;
+    free_tag_info(&rec->info);
+    free(rec->path);
+    rec->path = NULL;
+    return p_success;
+}
+
+#define EXPORT_COLUMNS 11
+
+/* Build every column in memory and write the index file */
+Status write_tag_index(const char *out_path, const TagRecord *recs, size_t count)
+{
+    ColBuf cols[EXPORT_COLUMNS];
+    memset(cols, 0, sizeof(cols));
+    const char **svals = malloc((count ? count : 1) * sizeof(char *));
+    uint32_t *uvals = malloc((count ? count : 1) * sizeof(uint32_t));
+    uint64_t *lvals = malloc((count ? count : 1) * sizeof(uint64_t));
+    Status st = p_failure;
+    FILE *out = NULL;
+    if (!svals || !uvals || !lvals)
+        goto out;
+
+#define STR_COLUMN(idx, name, field, builder)                       \
+    for (size_t i = 0; i < count; ++i)                              \
+        svals[i] = recs[i].field;                                   \
+    if (builder(&cols[idx], name, svals, count) != p_success)       \
+        goto out;
+
+    STR_COLUMN(0, frame_types[FT_TITLE].id, info.field[FT_TITLE], build_string_col)
+    STR_COLUMN(1, frame_types[FT_ARTIST].id, info.field[FT_ARTIST], build_dict_col)
+    STR_COLUMN(2, frame_types[FT_ALBUM].id, info.field[FT_ALBUM], build_dict_col)
+    STR_COLUMN(4, frame_types[FT_GENRE].id, info.field[FT_GENRE], build_dict_col)
+    STR_COLUMN(5, frame_types[FT_COMMENT].id, info.field[FT_COMMENT], build_string_col)
+    STR_COLUMN(6, "path", path, build_string_col)
+#undef STR_COLUMN
+
+    for (size_t i = 0; i < count; ++i)
+        uvals[i] = parse_year(recs[i].info.field[FT_YEAR]);
+    if (build_u32_col(&cols[3], frame_types[FT_YEAR].id, uvals, count) != p_success)
+        goto out;
+    for (size_t i = 0; i < count; ++i)
+        uvals[i] = recs[i].info.tag_size;
+    if (build_u32_col(&cols[7], "tagsize", uvals, count) != p_success)
+        goto out;
+    for (size_t i = 0; i < count; ++i)
+        lvals[i] = recs[i].file_size;
+    if (build_u64_col(&cols[8], "filesize", lvals, count) != p_success)
+        goto out;
+    for (size_t i = 0; i < count; ++i)
+        uvals[i] = ((uint32_t)recs[i].info.ver_major << 8) | recs[i].info.ver_rev;
+    if (build_u32_col(&cols[9], "version", uvals, count) != p_success)
+        goto out;
+    for (size_t i = 0; i < count; ++i)
+        lvals[i] = recs[i].mtime_ns;
+    if (build_u64_col(&cols[10], "mtime", lvals, count) != p_success)
+        goto out;
+
+    /* lay out payloads after header + directory */
+    ColFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, COL_MAGIC, 8);
+    hdr.endian = COL_ENDIAN_MARK;
+    hdr.version = COL_FORMAT_VERSION;
+    hdr.row_count = count;
+    hdr.column_count = EXPORT_COLUMNS;
+
+    uint64_t pos = sizeof(hdr) + EXPORT_COLUMNS * sizeof(ColDirEntry);
+    for (int c = 0; c < EXPORT_COLUMNS; ++c)
+    {
+        cols[c].dir.offset = pos;
+        cols[c].dir.length = cols[c].payload.len;
+        pos += cols[c].payload.len;
+    }
+
+    out = fopen(out_path, "wb");
+    if (!out)
+    {
+        printf("❌ERROR: Unable to open %s for writing.\n", out_path);
+        goto out;
+    }
+    if (fwrite(&hdr, sizeof(hdr), 1, out) != 1)
+        goto out;
+    for (int c = 0; c < EXPORT_COLUMNS; ++c)
+    {
+        if (fwrite(&cols[c].dir, sizeof(ColDirEntry), 1, out) != 1)
+            goto out;
+    }
+    for (int c = 0; c < EXPORT_COLUMNS; ++c)
+    {
+        if (cols[c].payload.len > 0 &&
+            fwrite(cols[c].payload.data, 1, cols[c].payload.len, out) != cols[c].payload.len)
+            goto out;
+    }
+    st = p_success;
+
+out:
+    if (out && fclose(out) != 0)
+        st = p_failure;
+    for (int c = 0; c < EXPORT_COLUMNS; ++c)
+        free(cols[c].payload.data);
+    free(svals);
+    free(uvals);
+    free(lvals);
+    return st;
+}
+
+/* CLI: -x <index_file> <file.mp3>...   ("-" reads one path per line from stdin) */
+Status export_tags(char *argv[])
+{
+    if (argv[2] == NULL || argv[3] == NULL)
+    {
+        printf("➡️INFO: For Exporting the Tags -> ./mp3_tag_reader -x <index_file> <file.mp3>... | -\n");
+        return p_failure;
+    }
+    const char *out_path = argv[2];
+    int from_stdin = (strcmp(argv[3], "-") == 0);
+
+    TagRecord *recs = NULL;
+    size_t count = 0, cap = 0, seen = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    int ai = 3;
+    Status st = p_failure;
+    for (;;)
+    {
+        const char *path;
+        if (from_stdin)
+        {
+            ssize_t n = getline(&line, &line_cap, stdin);
+            if (n < 0)
+                break;
+            if (n > 0 && line[n - 1] == '\n')
+                line[--n] = '\0';
+            if (n == 0)
+                continue;
+            path = line;
+        }
+        else
+        {
+            if (argv[ai] == NULL)
+                break;
+            path = argv[ai++];
+        }
+        seen++;
+
+        if (count >= cap)
+        {
+            cap = cap ? cap * 2 : 256;
+            TagRecord *tmp = realloc(recs, cap * sizeof(TagRecord));
+            if (!tmp)
+                goto out;
+            recs = tmp;
+        }
+        if (load_tag_record(path, &recs[count]) != p_success)
+        {
+            printf("⚠️WARNING: Skipping %s (not a readable ID3 file).\n", path);
+            continue;
+        }
+        count++;
+    }
+
+    if (write_tag_index(out_path, recs, count) != p_success)
+    {
+        printf("❌ERROR: Unable to write index %s.\n", out_path);
+        goto out;
+    }
+    printf("INFO: Exported %zu of %zu files to %s\n", count, seen, out_path);
+    st = p_success;
+
+out:
+    for (size_t i = 0; i < count; ++i)
+        free_tag_record(&recs[i]);
+    free(recs);
+    free(line);
+    return st;
+}
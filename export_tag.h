@@ -0,0 +1,80 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "types.h"
+#include "view_tag.h"
+#include <stdint.h>
+
+/*
+ * Columnar tag index ("-x" export).
+ *
+ * The file is written in host byte order so it can be mmap'ed and used in
+ * place.  Layout:
+ *   ColFileHeader
+ *   ColDirEntry[column_count]
+ *   column payloads, each starting on an 8 byte boundary
+ *
+ * Column payloads by kind:
+ *   COL_U32    : uint32_t[row_count], COL_U32_ABSENT where the file has
+ *                no (numeric) value
+ *   COL_U64    : uint64_t[row_count]
+ *   COL_STRING : uint64_t offsets[row_count + 1], then the string bytes
+ *                (padded to 8), then an absent bitmap of (row_count + 7) / 8
+ *                bytes where bit r is set if row r has no such frame.
+ *                Every string is NUL terminated so it can be used directly;
+ *                an absent row holds "".
+ *   COL_DICT   : uint32_t codes[row_count] (padded to 8), then a sorted
+ *                dictionary laid out like a COL_STRING column with
+ *                dict_count entries but no bitmap.  Equal codes mean equal
+ *                strings and code order is string order; COL_DICT_ABSENT
+ *                marks a row with no such frame.
+ */
+
+#define COL_MAGIC "MP3TCOL1"
+#define COL_ENDIAN_MARK 0x01020304u
+#define COL_FORMAT_VERSION 4u
+#define COL_U32_ABSENT UINT32_MAX
+#define COL_DICT_ABSENT UINT32_MAX
+
+typedef enum
+{
+    COL_U32 = 1,
+    COL_U64,
+    COL_STRING,
+    COL_DICT
+} ColKind;
+
+typedef struct _ColFileHeader
+{
+    char magic[8];
+    uint32_t endian;
+    uint32_t version;
+    uint64_t row_count;
+    uint32_t column_count;
+    uint32_t reserved;
+} ColFileHeader;
+
+typedef struct _ColDirEntry
+{
+    char name[8];      /* frame ID ("TPE1") or field name ("path"), NUL padded */
+    uint32_t kind;     /* ColKind */
+    uint32_t dict_count;
+    uint64_t offset;   /* from start of file */
+    uint64_t length;   /* payload bytes */
+} ColDirEntry;
+
+/* One file's worth of exported data */
+typedef struct _TagRecord
+{
+    char *path;
+    TagInfo info;
+    uint64_t file_size;
+    uint64_t mtime_ns;  /* st_mtim in nanoseconds since the epoch */
+} TagRecord;
+
+Status load_tag_record (const char *path, TagRecord *rec);
+Status free_tag_record (TagRecord *rec);
+Status write_tag_index (const char *out_path, const TagRecord *recs, size_t count);
+Status export_tags (char* argv[]);
+
+#endif
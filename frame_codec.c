@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "frame_codec.h"
+#include "view_tag.h"
+#include "types.h"
+
+#define INFLATE_INITIAL (64 * 1024)
+
+uint syncsafe_to_int(const unsigned char s[4])
+{
+    return ((s[0] & 0x7F) << 21) |
+           ((s[1] & 0x7F) << 14) |
+           ((s[2] & 0x7F) << 7) |
+           ((s[3] & 0x7F));
+}
+
+void int_to_syncsafe(uint val, unsigned char out[4])
+{
+    out[0] = (val >> 21) & 0x7F;
+    out[1] = (val >> 14) & 0x7F;
+    out[2] = (val >> 7) & 0x7F;
+    out[3] = val & 0x7F;
+}
+
+uint be32_to_uint(const unsigned char b[4])
+{
+    return ((uint)b[0] << 24) | ((uint)b[1] << 16) | ((uint)b[2] << 8) | (uint)b[3];
+}
+
+void uint_to_be32(uint v, unsigned char out[4])
+{
+    out[0] = (v >> 24) & 0xFF;
+    out[1] = (v >> 16) & 0xFF;
+    out[2] = (v >> 8) & 0xFF;
+    out[3] = v & 0xFF;
+}
+
+uint frame_size_from_bytes(unsigned char ver_major, const unsigned char b[4])
+{
+    return (ver_major >= 4) ? syncsafe_to_int(b) : be32_to_uint(b);
+}
+
+void frame_size_to_bytes(unsigned char ver_major, uint size, unsigned char out[4])
+{
+    if (ver_major >= 4)
+        int_to_syncsafe(size, out);
+    else
+        uint_to_be32(size, out);
+}
+
+/* Stream-inflate a zlib payload; expected (0 = unknown) and
+   FRAME_INFLATE_LIMIT both cap the output */
+static Status inflate_limited(const unsigned char *in, uint in_len, uint expected,
+                              unsigned char **out, uint *out_len)
+{
+    uint limit = (expected && expected < FRAME_INFLATE_LIMIT) ? expected : FRAME_INFLATE_LIMIT;
+    /* one byte of headroom lets inflate reach the stream trailer, and
+       tells an exact fit from an overrun */
+    size_t room = (size_t)limit + 1;
+    size_t cap = (expected || room < INFLATE_INITIAL) ? room : INFLATE_INITIAL;
+    unsigned char *buf = malloc(cap);
+    if (!buf)
+        return p_failure;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK)
+    {
+        free(buf);
+        return p_failure;
+    }
+    zs.next_in = (unsigned char *)in;
+    zs.avail_in = in_len;
+
+    int zr = Z_OK;
+    while (zr != Z_STREAM_END)
+    {
+        if (zs.total_out == cap)
+        {
+            /* out of room: grow, unless that would pass the limit */
+            if (cap >= room)
+                break;
+            size_t ncap = (cap * 2 > room) ? room : cap * 2;
+            unsigned char *tmp = realloc(buf, ncap);
+            if (!tmp)
+                break;
+            buf = tmp;
+            cap = ncap;
+        }
+        zs.next_out = buf + zs.total_out;
+        zs.avail_out = (uInt)(cap - zs.total_out);
+        zr = inflate(&zs, Z_NO_FLUSH);
+        if (zr != Z_OK && zr != Z_STREAM_END)
+            break;
+        if (zr == Z_OK && zs.avail_in == 0 && zs.avail_out != 0)
+            break; /* truncated stream */
+    }
+    uint produced = (uint)zs.total_out;
+    inflateEnd(&zs);
+    if (zr != Z_STREAM_END || produced > limit)
+    {
+        free(buf);
+        return p_failure;
+    }
+    *out = buf;
+    *out_len = produced;
+    return p_success;
+}
+
+/* Drop the 0x00 inserted after every 0xFF by unsynchronisation */
+static unsigned char *undo_unsync(const unsigned char *in, uint len, uint *out_len)
+{
+    unsigned char *out = malloc(len ? len : 1);
+    if (!out)
+        return NULL;
+    uint n = 0;
+    for (uint i = 0; i < len; ++i)
+    {
+        out[n++] = in[i];
+        if (in[i] == 0xFF && i + 1 < len && in[i + 1] == 0x00)
+            ++i;
+    }
+    *out_len = n;
+    return out;
+}
+
+static void decode_content(unsigned char ver_major, Frame *fr)
+{
+    fr->content_state = FRAME_CONTENT_UNAVAILABLE;
+    unsigned char fl = fr->flags[1];
+    const unsigned char *p = fr->data;
+    uint len = fr->size;
+    unsigned char *owned = NULL;
+    uint skip = 0, expected = 0;
+    int compressed;
+
+    if (ver_major >= 4)
+    {
+        if (fl & FRAME24_ENCRYPTED)
+            return;
+        /* unsynchronisation covers everything after the frame header,
+           group id and data length included: undo it before reading them */
+        if (fl & FRAME24_UNSYNC)
+        {
+            owned = undo_unsync(p, len, &len);
+            if (!owned)
+                return;
+            p = owned;
+        }
+        if (fl & FRAME24_GROUPED)
+            skip += 1;
+        if (fl & FRAME24_DATA_LENGTH)
+        {
+            if (len < skip + 4)
+                goto fail;
+            expected = syncsafe_to_int(p + skip);
+            skip += 4;
+        }
+        compressed = fl & FRAME24_COMPRESSED;
+    }
+    else
+    {
+        if (fl & FRAME23_ENCRYPTED)
+            return;
+        compressed = fl & FRAME23_COMPRESSED;
+        if (compressed)
+        {
+            if (len < 4)
+                return;
+            expected = be32_to_uint(p);
+            skip += 4;
+        }
+        if (fl & FRAME23_GROUPED)
+            skip += 1;
+    }
+    if (skip > len)
+        goto fail;
+    p += skip;
+    len -= skip;
+
+    if (compressed)
+    {
+        unsigned char *inflated;
+        uint inflated_len;
+        Status st = inflate_limited(p, len, expected, &inflated, &inflated_len);
+        free(owned);
+        if (st != p_success)
+            return;
+        owned = inflated;
+        len = inflated_len;
+    }
+    else if (owned && skip)
+    {
+        memmove(owned, p, len); /* content must start the owned buffer */
+    }
+
+    if (owned)
+    {
+        fr->content = owned;
+        fr->content_state = FRAME_CONTENT_DECODED;
+    }
+    else
+    {
+        fr->content = (unsigned char *)p;
+        fr->content_state = FRAME_CONTENT_RAW;
+    }
+    fr->content_size = len;
+    return;
+
+fail:
+    free(owned);
+}
+
+const unsigned char *frame_content(unsigned char ver_major, Frame *fr, uint *size)
+{
+    if (!fr)
+        return NULL;
+    if (fr->content_state == FRAME_CONTENT_UNREAD)
+        decode_content(ver_major, fr);
+    if (fr->content_state == FRAME_CONTENT_UNAVAILABLE)
+        return NULL;
+    *size = fr->content_size;
+    return fr->content;
+}
+
+void frame_content_free(Frame *fr)
+{
+    if (fr->content_state == FRAME_CONTENT_DECODED)
+        free(fr->content);
+    fr->content = NULL;
+    fr->content_size = 0;
+    fr->content_state = FRAME_CONTENT_UNREAD;
+}
+
+Status frame_compress(unsigned char ver_major, unsigned char flags[2], unsigned char **data, uint *size)
+{
+    unsigned char mask = (ver_major >= 4) ? FRAME24_FORMAT_MASK : FRAME23_FORMAT_MASK;
+    if (*size < FRAME_COMPRESS_MIN || (flags[1] & mask))
+        return p_failure;
+    if (ver_major >= 4 && *size >= (1u << 28))
+        return p_failure; /* does not fit the syncsafe data length */
+
+    uLongf packed_len = compressBound(*size);
+    unsigned char *out = malloc(4 + packed_len);
+    if (!out)
+        return p_failure;
+    if (compress2(out + 4, &packed_len, *data, *size, Z_BEST_COMPRESSION) != Z_OK ||
+        4 + packed_len >= *size)
+    {
+        free(out);
+        return p_failure;
+    }
+
+    if (ver_major >= 4)
+    {
+        int_to_syncsafe(*size, out);
+        flags[1] |= FRAME24_COMPRESSED | FRAME24_DATA_LENGTH;
+    }
+    else
+    {
+        uint_to_be32(*size, out);
+        flags[1] |= FRAME23_COMPRESSED;
+    }
+    free(*data);
+    *data = out;
+    *size = (uint)(4 + packed_len);
+    return p_success;
+}
@@ -0,0 +1,67 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include "types.h"
+#include "view_tag.h"
+
+/*
+ * Frame format flags (second flag byte) and the payload transforms they
+ * imply.  Parsing keeps frames exactly as stored; the decoded payload is
+ * produced on first use by frame_content(), so scans that never touch a
+ * compressed frame never inflate it.
+ *
+ * Extra bytes ahead of the payload, in file order:
+ *   v2.3: decompressed size (be32, if compressed), method (1, if
+ *         encrypted), group id (1, if grouped)
+ *   v2.4: group id (1), method (1, if encrypted), data length (syncsafe,
+ *         if data length indicator)
+ */
+
+#define FRAME23_COMPRESSED  0x80
+#define FRAME23_ENCRYPTED   0x40
+#define FRAME23_GROUPED     0x20
+#define FRAME23_FORMAT_MASK 0xE0
+
+#define FRAME24_GROUPED     0x40
+#define FRAME24_COMPRESSED  0x08
+#define FRAME24_ENCRYPTED   0x04
+#define FRAME24_UNSYNC      0x02
+#define FRAME24_DATA_LENGTH 0x01
+#define FRAME24_FORMAT_MASK 0x4F
+
+/* Inflated payloads larger than this are treated as corrupt */
+#define FRAME_INFLATE_LIMIT (16u * 1024 * 1024)
+/* Frames smaller than this are never worth compressing */
+#define FRAME_COMPRESS_MIN 1024
+
+/* Frame.content_state */
+typedef enum
+{
+    FRAME_CONTENT_UNREAD,      /* not decoded yet */
+    FRAME_CONTENT_RAW,         /* content points into data */
+    FRAME_CONTENT_DECODED,     /* content is an owned buffer */
+    FRAME_CONTENT_UNAVAILABLE  /* encrypted or corrupt */
+} FrameContentState;
+
+/* 28-bit syncsafe integers (tag size, v2.4 frame sizes) and plain
+   big-endian 32-bit ones (v2.3 frame sizes), as stored in the file */
+uint syncsafe_to_int (const unsigned char s[4]);
+void int_to_syncsafe (uint val, unsigned char out[4]);
+uint be32_to_uint (const unsigned char b[4]);
+void uint_to_be32 (uint val, unsigned char out[4]);
+
+/* Frame header size field: big-endian in v2.3, syncsafe from v2.4 on */
+uint frame_size_from_bytes (unsigned char ver_major, const unsigned char b[4]);
+void frame_size_to_bytes (unsigned char ver_major, uint size, unsigned char out[4]);
+
+/* Decoded payload of fr (decompressed, de-unsynchronised), cached on the
+   frame; NULL when it cannot be decoded */
+const unsigned char *frame_content (unsigned char ver_major, Frame *fr, uint *size);
+void frame_content_free (Frame *fr);
+
+/* Compress a plain frame payload in place, updating its flags.  Returns
+   p_failure and leaves everything untouched when the frame is small,
+   already carries format flags, or would not shrink */
+Status frame_compress (unsigned char ver_major, unsigned char flags[2], unsigned char **data, uint *size);
+
+#endif
@@ -0,0 +1,75 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "frame_registry.h"
+#include "types.h"
+
+/* Single source of truth for every frame the tool reads, edits and exports */
+const FrameType frame_types[FRAME_TYPE_COUNT] = {
+    [FT_TITLE]   = {"-t", "TIT2", "Title",   FRAME_DECODE_TEXT},
+    [FT_ALBUM]   = {"-a", "TALB", "Album",   FRAME_DECODE_TEXT},
+    [FT_YEAR]    = {"-y", "TYER", "Year",    FRAME_DECODE_TEXT},
+    [FT_GENRE]   = {"-G", "TCON", "Genre",   FRAME_DECODE_TEXT},
+    [FT_ARTIST]  = {"-A", "TPE1", "Artist",  FRAME_DECODE_TEXT},
+    [FT_COMMENT] = {"-c", "COMM", "Comment", FRAME_DECODE_COMMENT},
+};
+
+/* Open addressed hash of packed ID -> registry index; must stay a power of two
+   and comfortably larger than FRAME_TYPE_COUNT */
+#define FRAME_HASH_SLOTS 32
+#define FRAME_HASH_SHIFT 27
+
+static uint32_t hash_keys[FRAME_HASH_SLOTS];
+static signed char hash_vals[FRAME_HASH_SLOTS];
+static pthread_once_t hash_once = PTHREAD_ONCE_INIT;
+
+static uint32_t frame_hash(uint32_t packed_id)
+{
+    return (packed_id * 2654435761u) >> FRAME_HASH_SHIFT;
+}
+
+static void build_frame_hash(void)
+{
+    memset(hash_vals, -1, sizeof(hash_vals));
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        uint32_t key = pack_frame_id(frame_types[i].id);
+        uint32_t h = frame_hash(key);
+        while (hash_vals[h] >= 0)
+            h = (h + 1) & (FRAME_HASH_SLOTS - 1);
+        hash_keys[h] = key;
+        hash_vals[h] = (signed char)i;
+    }
+}
+
+uint32_t pack_frame_id(const char id[4])
+{
+    const unsigned char *b = (const unsigned char *)id;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+int frame_type_by_id(uint32_t packed_id)
+{
+    pthread_once(&hash_once, build_frame_hash);
+    uint32_t h = frame_hash(packed_id);
+    while (hash_vals[h] >= 0)
+    {
+        if (hash_keys[h] == packed_id)
+            return hash_vals[h];
+        h = (h + 1) & (FRAME_HASH_SLOTS - 1);
+    }
+    return -1;
+}
+
+int frame_type_by_flag(const char *flag)
+{
+    if (!flag)
+        return -1;
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        if (strcmp(frame_types[i].flag, flag) == 0)
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,43 @@
+#ifndef FRAME_REGISTRY_H
+#define FRAME_REGISTRY_H
+
+#include "types.h"
+#include <stdint.h>
+
+/* How the payload of a registered frame is turned into text */
+typedef enum
+{
+    FRAME_DECODE_TEXT,     /* enc(1) + text */
+    FRAME_DECODE_COMMENT   /* enc(1) + lang(3) + shortdesc('\0') + text */
+} FrameDecoder;
+
+/* Registered frame types, in the order -v prints them */
+typedef enum
+{
+    FT_TITLE,
+    FT_ALBUM,
+    FT_YEAR,
+    FT_GENRE,
+    FT_ARTIST,
+    FT_COMMENT,
+    FRAME_TYPE_COUNT
+} FrameTypeIndex;
+
+typedef struct _FrameType
+{
+    const char *flag;      /* CLI modifier for -e */
+    const char *id;        /* 4 char frame ID */
+    const char *name;      /* display name */
+    FrameDecoder decoder;
+} FrameType;
+
+extern const FrameType frame_types[FRAME_TYPE_COUNT];
+
+/* Frame IDs packed big-endian into one integer, "TIT2" -> 0x54495432 */
+uint32_t pack_frame_id (const char id[4]);
+
+/* Registry lookups; both return -1 when the frame type is not registered */
+int frame_type_by_id (uint32_t packed_id);
+int frame_type_by_flag (const char *flag);
+
+#endif
@@ -0,0 +1,365 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "journal_tag.h"
+#include "audio_hash.h"
+#include "mp3_io.h"
+#include "frame_codec.h"
+#include "types.h"
+
+#define ROLLBACK_MAX_WORKERS 32
+
+static uint32_t record_crc(const JournalRecord *rec, const void *payload, size_t payload_len)
+{
+    JournalRecord tmp = *rec;
+    tmp.record_crc = 0;
+    AudioHash h;
+    audio_hash_init(&h);
+    audio_hash_update(&h, &tmp, sizeof(tmp));
+    audio_hash_update(&h, payload, payload_len);
+    return audio_hash_value(&h);
+}
+
+/* Append one record in a single write and make it durable */
+Status journal_append(const char *journal_path, const char *file_path, const unsigned char header[10],
+                      const unsigned char *tag, uint tag_len, const AudioHash *audio)
+{
+    size_t path_len = strlen(file_path);
+    size_t total = sizeof(JournalRecord) + path_len + tag_len;
+    unsigned char *buf = malloc(total);
+    if (!buf)
+        return p_failure;
+
+    JournalRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    memcpy(rec.magic, JOURNAL_MAGIC, 4);
+    rec.path_len = (uint32_t)path_len;
+    rec.tag_len = tag_len;
+    rec.audio_crc = audio_hash_value(audio);
+    rec.audio_size = audio->bytes;
+    rec.timestamp = (uint64_t)time(NULL);
+    memcpy(rec.header, header, 10);
+    memcpy(buf + sizeof(rec), file_path, path_len);
+    if (tag_len > 0)
+        memcpy(buf + sizeof(rec) + path_len, tag, tag_len);
+    rec.record_crc = record_crc(&rec, buf + sizeof(rec), path_len + tag_len);
+    memcpy(buf, &rec, sizeof(rec));
+
+    Status st = p_failure;
+    int fd = open(journal_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd >= 0)
+    {
+        size_t off = 0;
+        while (off < total)
+        {
+            ssize_t n = write(fd, buf + off, total - off);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            off += (size_t)n;
+        }
+        if (off == total && fsync(fd) == 0)
+            st = p_success;
+        close(fd);
+    }
+    free(buf);
+    return st;
+}
+
+/* Parsed view of one record inside the mapped journal */
+typedef struct
+{
+    JournalRecord rec;        /* copied out: records in the file are not aligned */
+    size_t order;             /* position in the journal */
+    char *path;
+    const unsigned char *tag;
+    uint frames_len;          /* tag bytes up to the end of the last frame, i.e. without padding */
+} RollbackItem;
+
+typedef struct
+{
+    RollbackItem *items;
+    size_t count;
+    size_t next;      /* shared work cursor */
+    int verify;
+    size_t restored;
+    size_t failed;
+} RollbackJob;
+
+/* End of the last frame in a journaled tag area.  Everything after it is
+   padding, which a rollback may shrink or grow freely */
+static uint frames_extent(const JournalRecord *rec, const unsigned char *tag)
+{
+    uint offset = 0;
+    while (offset + 10 <= rec->tag_len && tag[offset] != 0)
+    {
+        uint size = frame_size_from_bytes(rec->header[3], tag + offset + 4);
+        if (size > rec->tag_len - offset - 10)
+            return rec->tag_len; /* malformed: keep every byte */
+        offset += 10 + size;
+    }
+    return offset;
+}
+
+/* Original frames padded out to new_tag_size, ready to be written at offset 0 */
+static unsigned char *build_tag_area(const RollbackItem *it, uint new_tag_size)
+{
+    unsigned char *area = calloc(1, 10 + (size_t)new_tag_size);
+    if (!area)
+        return NULL;
+    memcpy(area, it->rec.header, 10);
+    int_to_syncsafe(new_tag_size, area + 6);
+    memcpy(area + 10, it->tag, it->frames_len);
+    return area;
+}
+
+/* Tag does not fit in the current tag area: write header, tag and padding
+   to a temp file, move the audio across and rename over the original */
+static Status padded_rewrite(const RollbackItem *it, Mp3IO *src, off_t audio_off)
+{
+    /* unique temp beside the file, as edit_tag does: concurrent rollbacks
+       and edits of the same file never share (or truncate) one */
+    char tmp_path[PATH_MAX];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", it->path) >= (int)sizeof(tmp_path))
+        return p_failure;
+    uint new_tag_size = it->frames_len + JOURNAL_ROLLBACK_PADDING;
+    unsigned char *area = build_tag_area(it, new_tag_size);
+    int tfd = area ? mkostemp(tmp_path, O_CLOEXEC) : -1;
+    if (tfd < 0)
+        tmp_path[0] = '\0';
+    Status st = p_failure;
+    Mp3IO dst;
+    dst.fd = -1;
+    struct stat sb;
+    if (tfd < 0 || mp3io_open_fd(&dst, tfd) != p_success ||
+        fstat(src->fd, &sb) != 0 || fchmod(dst.fd, sb.st_mode & 07777) != 0)
+        goto out;
+    if (mp3io_write_full(&dst, area, 10 + (size_t)new_tag_size, 0) != p_success)
+        goto out;
+    if (mp3io_copy_to_end(src, audio_off, &dst, 10 + (off_t)new_tag_size, NULL) != p_success)
+        goto out;
+    if (fsync(dst.fd) != 0 || mp3io_close(&dst) != p_success)
+        goto out;
+    if (rename(tmp_path, it->path) == 0)
+        st = p_success;
+
+out:
+    mp3io_close(&dst);
+    if (st != p_success && tmp_path[0])
+        unlink(tmp_path);
+    free(area);
+    return st;
+}
+
+static Status restore_one(const RollbackItem *it, int verify, const char **why)
+{
+    Mp3IO io;
+    if (mp3io_open(&io, it->path, O_RDWR) != p_success)
+    {
+        *why = "unable to open file";
+        return p_failure;
+    }
+    Status st = p_failure;
+    unsigned char header[10];
+    if (mp3io_read_full(&io, header, 10, 0) != p_success || strncmp((char *)header, "ID3", 3) != 0)
+    {
+        *why = "not an ID3 file any more";
+        goto out;
+    }
+
+    /* the audio must be exactly what was there when the edit was journaled */
+    uint cur_tag_size = syncsafe_to_int(header + 6);
+    off_t audio_off = 10 + (off_t)cur_tag_size;
+    if (io.size < audio_off || (uint64_t)(io.size - audio_off) != it->rec.audio_size)
+    {
+        *why = "audio size changed since the edit";
+        goto out;
+    }
+    if (verify)
+    {
+        AudioHash h;
+        audio_hash_init(&h);
+        if (mp3io_copy_to_end(&io, audio_off, NULL, 0, &h) != p_success || audio_hash_value(&h) != it->rec.audio_crc)
+        {
+            *why = "audio checksum changed since the edit";
+            goto out;
+        }
+    }
+
+    /* the journaled padding does not count: the edit that dropped it is being undone */
+    if (it->frames_len <= cur_tag_size)
+    {
+        /* fits: overwrite the tag area in place, only tag bytes are touched */
+        unsigned char *area = build_tag_area(it, cur_tag_size);
+        if (area && mp3io_write_full(&io, area, 10 + (size_t)cur_tag_size, 0) == p_success && fsync(io.fd) == 0)
+            st = p_success;
+        free(area);
+        if (st != p_success)
+            *why = "write failed";
+    }
+    else
+    {
+        st = padded_rewrite(it, &io, audio_off);
+        if (st != p_success)
+            *why = "rewrite failed";
+    }
+
+out:
+    mp3io_close(&io);
+    return st;
+}
+
+static void *rollback_worker(void *arg)
+{
+    RollbackJob *job = arg;
+    for (;;)
+    {
+        size_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+        if (i >= job->count)
+            break;
+        const char *why = NULL;
+        if (restore_one(&job->items[i], job->verify, &why) == p_success)
+            __atomic_fetch_add(&job->restored, 1, __ATOMIC_RELAXED);
+        else
+        {
+            __atomic_fetch_add(&job->failed, 1, __ATOMIC_RELAXED);
+            printf("⚠️WARNING: %s not restored (%s).\n", job->items[i].path, why);
+        }
+    }
+    return NULL;
+}
+
+static int cmp_item_path(const void *a, const void *b)
+{
+    const RollbackItem *x = a, *y = b;
+    int c = strcmp(x->path, y->path);
+    if (c != 0)
+        return c;
+    return (x->order > y->order) - (x->order < y->order); /* keep journal order within a path */
+}
+
+/* CLI: -r <journal> [--verify] -- restore every file to its state before its first journaled edit */
+Status rollback_journal(char *argv[])
+{
+    if (argv[2] == NULL)
+    {
+        printf("➡️INFO: For Rolling back edits -> ./mp3_tag_reader -r <journal_file> [--verify]\n");
+        return p_failure;
+    }
+    int verify = 0;
+    for (int i = 3; argv[i] != NULL; ++i)
+    {
+        if (strcmp(argv[i], "--verify") == 0)
+            verify = 1;
+        else
+        {
+            printf("❌ERROR: Unsupported option %s.\n", argv[i]);
+            return p_failure;
+        }
+    }
+
+    int fd = open(argv[2], O_RDONLY | O_CLOEXEC);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0 || sb.st_size == 0)
+    {
+        printf("❌ERROR: Unable to read journal %s.\n", argv[2]);
+        if (fd >= 0)
+            close(fd);
+        return p_failure;
+    }
+    unsigned char *base = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        printf("❌ERROR: Unable to read journal %s.\n", argv[2]);
+        return p_failure;
+    }
+
+    /* walk records; stop at the first torn or corrupt one */
+    RollbackItem *items = NULL;
+    size_t count = 0, cap = 0, off = 0;
+    Status st = p_failure;
+    while (off + sizeof(JournalRecord) <= (size_t)sb.st_size)
+    {
+        JournalRecord rec;
+        memcpy(&rec, base + off, sizeof(rec));
+        size_t payload = (size_t)rec.path_len + rec.tag_len;
+        if (memcmp(rec.magic, JOURNAL_MAGIC, 4) != 0 || rec.path_len == 0 || rec.path_len >= PATH_MAX ||
+            payload > (size_t)sb.st_size - off - sizeof(rec) ||
+            record_crc(&rec, base + off + sizeof(rec), payload) != rec.record_crc)
+        {
+            printf("⚠️WARNING: Ignoring damaged journal data at offset %zu.\n", off);
+            break;
+        }
+        if (count >= cap)
+        {
+            cap = cap ? cap * 2 : 256;
+            RollbackItem *tmp = realloc(items, cap * sizeof(RollbackItem));
+            if (!tmp)
+                goto out;
+            items = tmp;
+        }
+        RollbackItem *it = &items[count];
+        it->rec = rec;
+        it->order = count;
+        it->path = strndup((const char *)(base + off + sizeof(rec)), rec.path_len);
+        it->tag = base + off + sizeof(rec) + rec.path_len;
+        it->frames_len = frames_extent(&rec, it->tag);
+        if (!it->path)
+            goto out;
+        count++;
+        off += sizeof(rec) + payload;
+    }
+
+    /* only the oldest record per file describes the state before the bulk edit */
+    qsort(items, count, sizeof(RollbackItem), cmp_item_path);
+    size_t uniq = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (uniq > 0 && strcmp(items[uniq - 1].path, items[i].path) == 0)
+        {
+            free(items[i].path);
+            continue;
+        }
+        items[uniq++] = items[i];
+    }
+    count = uniq;
+
+    RollbackJob job = {items, count, 0, verify, 0, 0};
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nworkers = ncpu < 1 ? 1 : (ncpu > ROLLBACK_MAX_WORKERS ? ROLLBACK_MAX_WORKERS : (int)ncpu);
+    if ((size_t)nworkers > count)
+        nworkers = count ? (int)count : 1;
+    pthread_t workers[ROLLBACK_MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < nworkers; ++i)
+    {
+        if (pthread_create(&workers[i], NULL, rollback_worker, &job) == 0)
+            started++;
+    }
+    if (started == 0)
+        rollback_worker(&job);
+    for (int i = 0; i < started; ++i)
+        pthread_join(workers[i], NULL);
+
+    printf("INFO: Restored %zu of %zu files from %s.\n", job.restored, count, argv[2]);
+    st = job.failed ? p_failure : p_success;
+
+out:
+    for (size_t i = 0; i < count; ++i)
+        free(items[i].path);
+    free(items);
+    munmap(base, sb.st_size);
+    return st;
+}
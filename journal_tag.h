@@ -0,0 +1,39 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "types.h"
+#include "audio_hash.h"
+#include <stdint.h>
+
+/*
+ * Append-only undo journal for tag edits ("-e ... --journal <file>").
+ *
+ * Each edit appends one record, written with a single write() and fsync'ed
+ * before the edited file replaces the original:
+ *   JournalRecord | path bytes (path_len) | original tag area (tag_len)
+ * record_crc is the CRC-32 of the whole record with record_crc zeroed, so
+ * a torn final record is detected and ignored.
+ */
+
+#define JOURNAL_MAGIC "MTJ1"
+/* Extra padding left in a tag that has to be rewritten during rollback */
+#define JOURNAL_ROLLBACK_PADDING 2048
+
+typedef struct _JournalRecord
+{
+    char magic[4];
+    uint32_t path_len;
+    uint32_t tag_len;         /* bytes after the 10 byte ID3 header, padding included */
+    uint32_t audio_crc;       /* CRC-32 of everything after the tag */
+    uint64_t audio_size;
+    uint64_t timestamp;       /* seconds since the epoch */
+    unsigned char header[10]; /* original ID3 header */
+    unsigned char reserved[2];
+    uint32_t record_crc;
+} JournalRecord;
+
+Status journal_append (const char *journal_path, const char *file_path, const unsigned char header[10],
+                       const unsigned char *tag, uint tag_len, const AudioHash *audio);
+Status rollback_journal (char* argv[]);
+
+#endif
@@ -1,8 +1,16 @@
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <string.h>
 #include "types.h"
 #include "view_tag.h"
 #include "edit_tag.h"
+#include "export_tag.h"
+#include "query_tag.h"
+#include "frame_registry.h"
+#include "daemon_tag.h"
+#include "watch_tag.h"
+#include "journal_tag.h"
+#include "mp3_io.h"
 
 int main(int argc, char *argv[])
 {
@@ -22,7 +30,10 @@ int main(int argc, char *argv[])
         char filename[1024] = {0};
         if (read_and_validate_mp3_file(argv, filename) == p_success)
         {
-            if (view_tag(argv, filename) == p_success)
+            Status res;
+            if (forward_to_daemon(argv, op, &res) != p_success)
+                res = view_tag(argv, filename);
+            if (res == p_success)
             {
                 printf("INFO: Done.✅\n");
                 printf("============================================================\n");
@@ -36,26 +47,76 @@ int main(int argc, char *argv[])
         TagData td = {0};
         if (read_and_validate_mp3_file_args(argv, &td) == p_success)
         {
-            if (edit_tag(argv, &td) == p_success)
+            Status res;
+            if (forward_to_daemon(argv, op, &res) != p_success)
+                res = edit_tag(argv, &td);
+            if (res == p_success)
             {
                 printf("INFO: Done.✅\n");
                 printf("============================================================\n");
             }
         }
     }
+    else if (op == p_export)
+    {
+        printf("============================================================\n");
+        if (export_tags(argv) == p_success)
+        {
+            printf("INFO: Done.✅\n");
+            printf("============================================================\n");
+        }
+    }
+    else if (op == p_query)
+    {
+        Status res;
+        if (forward_to_daemon(argv, op, &res) != p_success)
+            res = query_tags(argv);
+        if (res != p_success)
+            printf("INFO: Use \"./mp3_tag_reader --help\" for Help menu.\n");
+    }
+    else if (op == p_daemon)
+    {
+        run_daemon(argv);
+    }
+    else if (op == p_watch)
+    {
+        printf("============================================================\n");
+        watch_tags(argv);
+    }
+    else if (op == p_rollback)
+    {
+        printf("============================================================\n");
+        if (rollback_journal(argv) == p_success)
+        {
+            printf("INFO: Done.✅\n");
+            printf("============================================================\n");
+        }
+    }
     else if (op == p_help)
     {
         printf("Help menu for Mp3 Tag Reader and Editor:⤵️\n");
         printf("For viewing the tags - ./mp3_tag_reader -v <filename.mp3>\n");
-        printf("For editing the tags - ./mp3_tag_reader -e <modifier> \"New_Value\" <file_name.mp3>\n");
+        printf("For editing the tags - ./mp3_tag_reader -e <modifier> \"New_Value\" <file_name.mp3> [--verify] [--journal <journal_file>] [--compress]\n");
+        printf("    --verify checks the copied audio before the original file is replaced\n");
+        printf("    --journal appends the original tag to an undo journal before the file is replaced\n");
+        printf("    --compress stores large frames zlib-compressed\n");
+        printf("For undoing journaled edits - ./mp3_tag_reader -r <journal_file> [--verify]\n");
+        printf("For exporting an index - ./mp3_tag_reader -x <index_file> <file.mp3>... (or - to read paths from stdin)\n");
+        printf("For querying an index - ./mp3_tag_reader -q <index_file> [count|distinct FIELD] [FIELD<op>VALUE ...]\n");
+        printf("    FIELD is a frame ID (");
+        for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+            printf(i ? " %s" : "%s", frame_types[i].id);
+        printf(") or path/tagsize/filesize/version/mtime\n");
+        printf("    files without the frame (or without a numeric %s) match no filter on it and group as \"-\"\n",
+               frame_types[FT_YEAR].id);
+        printf("For keeping an index current - ./mp3_tag_reader -w <music_dir> <index_file>\n");
+        printf("For serving requests - ./mp3_tag_reader -d [socket_path]\n");
+        printf("    -v/-e/-q are forwarded to the daemon when one is listening on $%s (default %s)\n",
+               DAEMON_SOCKET_ENV, daemon_default_socket_path());
+        printf("    the daemon always reads with pread; $%s=mmap only applies to local runs\n", MP3_IO_ENV);
         printf("Modifier Function⤵️\n");
-        printf("-t    Modify Title Tag\n");
-        // printf("-T    Modify Track Tag\n");
-        printf("-a    Modify Artist Tag\n");
-        printf("-A    Modify Album Tag\n");
-        printf("-y    Modify Year Tag\n");
-        printf("-c    Modify Comment Tag\n");
-        printf("-g    Modify Genre Tag\n");
+        for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+            printf("%s    Modify %s Tag\n", frame_types[i].flag, frame_types[i].name);
     }
     else
     {
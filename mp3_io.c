@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mp3_io.h"
+#include "audio_hash.h"
+#include "types.h"
+
+/* pread backend */
+
+static Status pread_open(Mp3IO *io)
+{
+    (void)io;
+    return p_success;
+}
+
+static ssize_t pread_read_at(Mp3IO *io, void *buf, size_t len, off_t off)
+{
+    ssize_t n;
+    do
+        n = pread(io->fd, buf, len, off);
+    while (n < 0 && errno == EINTR);
+    return n;
+}
+
+static ssize_t pwrite_write_at(Mp3IO *io, const void *buf, size_t len, off_t off)
+{
+    ssize_t n;
+    do
+        n = pwrite(io->fd, buf, len, off);
+    while (n < 0 && errno == EINTR);
+    return n;
+}
+
+/* Chunked copy through a bounce buffer, using the source's read_at */
+static Status buffered_copy_to(Mp3IO *src, off_t src_off, Mp3IO *dst, off_t dst_off, AudioHash *h)
+{
+    unsigned char *buf = malloc(MP3_IO_CHUNK);
+    if (!buf)
+        return p_failure;
+    Status st = p_success;
+    for (;;)
+    {
+        ssize_t n = src->backend->read_at(src, buf, MP3_IO_CHUNK, src_off);
+        if (n == 0)
+            break;
+        if (n < 0)
+        {
+            st = p_failure;
+            break;
+        }
+        if (h)
+            audio_hash_update(h, buf, (size_t)n);
+        if (dst && mp3io_write_full(dst, buf, (size_t)n, dst_off) != p_success)
+        {
+            st = p_failure;
+            break;
+        }
+        src_off += n;
+        dst_off += n;
+    }
+    free(buf);
+    return st;
+}
+
+static void pread_close(Mp3IO *io)
+{
+    (void)io;
+}
+
+/* mmap backend */
+
+static Status mmap_open(Mp3IO *io)
+{
+    if (io->size == 0)
+        return p_success; /* nothing to map; reads just hit EOF */
+    void *p = mmap(NULL, (size_t)io->size, PROT_READ, MAP_SHARED, io->fd, 0);
+    if (p == MAP_FAILED)
+        return p_failure;
+    madvise(p, (size_t)io->size, MADV_SEQUENTIAL);
+    io->map = p;
+    return p_success;
+}
+
+static ssize_t mmap_read_at(Mp3IO *io, void *buf, size_t len, off_t off)
+{
+    if (off >= io->size)
+        return 0;
+    if ((off_t)len > io->size - off)
+        len = (size_t)(io->size - off);
+    memcpy(buf, io->map + off, len);
+    return (ssize_t)len;
+}
+
+/* Hash and write straight from the mapping: no bounce buffer */
+static Status mmap_copy_to(Mp3IO *src, off_t src_off, Mp3IO *dst, off_t dst_off, AudioHash *h)
+{
+    while (src_off < src->size)
+    {
+        size_t n = (size_t)(src->size - src_off);
+        if (n > MP3_IO_CHUNK)
+            n = MP3_IO_CHUNK;
+        const unsigned char *p = src->map + src_off;
+        if (h)
+            audio_hash_update(h, p, n);
+        if (dst && mp3io_write_full(dst, p, n, dst_off) != p_success)
+            return p_failure;
+        src_off += n;
+        dst_off += n;
+    }
+    return p_success;
+}
+
+static void mmap_close(Mp3IO *io)
+{
+    if (io->map)
+        munmap((void *)io->map, (size_t)io->size);
+    io->map = NULL;
+}
+
+/* the mapping is read-only and fixed in size, so mmap writes with pwrite() */
+static const Mp3IOBackend backends[] = {
+    {"pread", pread_open, pread_read_at, pwrite_write_at, buffered_copy_to, pread_close},
+    {"mmap", mmap_open, mmap_read_at, pwrite_write_at, mmap_copy_to, mmap_close},
+};
+
+static int mmap_disabled = 0;
+
+void mp3io_disable_mmap(void)
+{
+    mmap_disabled = 1;
+}
+
+static const Mp3IOBackend *select_backend(void)
+{
+    const char *want = getenv(MP3_IO_ENV);
+    if (want)
+    {
+        for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); ++i)
+        {
+            if (mmap_disabled && backends[i].open == mmap_open)
+                continue;
+            if (strcmp(backends[i].name, want) == 0)
+                return &backends[i];
+        }
+    }
+    return &backends[0];
+}
+
+Status mp3io_open_fd(Mp3IO *io, int fd)
+{
+    memset(io, 0, sizeof(*io));
+    io->fd = fd;
+    if (io->fd < 0)
+        return p_failure;
+    struct stat st;
+    if (fstat(io->fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(io->fd);
+        io->fd = -1;
+        return p_failure;
+    }
+    io->size = st.st_size;
+    io->backend = select_backend();
+    if (io->backend->open(io) != p_success)
+    {
+        /* e.g. address space exhausted on a 32-bit build: pread always works */
+        io->backend = &backends[0];
+        io->map = NULL;
+    }
+    return p_success;
+}
+
+Status mp3io_open(Mp3IO *io, const char *path, int flags)
+{
+    return mp3io_open_fd(io, open(path, flags | O_CLOEXEC));
+}
+
+Status mp3io_close(Mp3IO *io)
+{
+    if (!io || io->fd < 0)
+        return p_failure;
+    io->backend->close(io);
+    int rc = close(io->fd);
+    io->fd = -1;
+    return rc == 0 ? p_success : p_failure;
+}
+
+Status mp3io_read_full(Mp3IO *io, void *buf, size_t len, off_t off)
+{
+    unsigned char *p = buf;
+    while (len > 0)
+    {
+        ssize_t n = io->backend->read_at(io, p, len, off);
+        if (n <= 0)
+            return p_failure;
+        p += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return p_success;
+}
+
+const unsigned char *mp3io_peek(Mp3IO *io, off_t off, size_t len)
+{
+    if (!io->map || off < 0 || off > io->size || (off_t)len > io->size - off)
+        return NULL;
+    return io->map + off;
+}
+
+Status mp3io_write_full(Mp3IO *io, const void *buf, size_t len, off_t off)
+{
+    const unsigned char *p = buf;
+    while (len > 0)
+    {
+        ssize_t n = io->backend->write_at(io, p, len, off);
+        if (n <= 0)
+            return p_failure;
+        p += n;
+        len -= (size_t)n;
+        off += n;
+    }
+    return p_success;
+}
+
+Status mp3io_copy_to_end(Mp3IO *src, off_t src_off, Mp3IO *dst, off_t dst_off, AudioHash *h)
+{
+    if (src_off > src->size)
+        return p_failure;
+    return src->backend->copy_to(src, src_off, dst, dst_off, h);
+}
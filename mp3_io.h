@@ -0,0 +1,83 @@
+#ifndef MP3_IO_H
+#define MP3_IO_H
+
+/* Mp3IO holds off_t fields, so every file that sees it must agree on their
+   size: start each .c with #define _FILE_OFFSET_BITS 64, before any include */
+#if !defined(_FILE_OFFSET_BITS) || _FILE_OFFSET_BITS != 64
+#error "_FILE_OFFSET_BITS must be defined as 64 before the first #include"
+#endif
+
+#include "types.h"
+#include "audio_hash.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Positional, fd based file access used by the read and edit paths.
+ * All offsets are off_t (64-bit: every translation unit is built with
+ * _FILE_OFFSET_BITS=64), so files over 2 GB are handled.  Nothing here
+ * keeps a file position, so one Mp3IO can be read from several threads.
+ *
+ * The backend is chosen per open from $MP3_TAG_IO:
+ *   pread (default)  pread()/pwrite() through the caller's buffer
+ *   mmap             file mapped read-only; tag parsing and audio
+ *                    copies work straight from the mapping, writes
+ *                    use pwrite()
+ * Every read, write and copy goes through the backend table, so new
+ * backends (e.g. io_uring) only need another Mp3IOBackend entry.
+ *
+ * The mapping is MAP_SHARED and there is no SIGBUS handler: if another
+ * process truncates a mapped file, touching the lost pages kills the
+ * process.  That is acceptable for a one-shot CLI run but not for the
+ * daemon, which calls mp3io_disable_mmap() and always uses pread.
+ */
+
+#define MP3_IO_ENV "MP3_TAG_IO"
+#define MP3_IO_CHUNK (256 * 1024)
+
+typedef struct _Mp3IO Mp3IO;
+
+typedef struct _Mp3IOBackend
+{
+    const char *name;
+    Status (*open)(Mp3IO *io);
+    ssize_t (*read_at)(Mp3IO *io, void *buf, size_t len, off_t off);
+    ssize_t (*write_at)(Mp3IO *io, const void *buf, size_t len, off_t off);
+    /* [src_off, EOF) of src to dst at dst_off (dst NULL: read only), feeding h when set */
+    Status (*copy_to)(Mp3IO *src, off_t src_off, Mp3IO *dst, off_t dst_off, AudioHash *h);
+    void (*close)(Mp3IO *io);
+} Mp3IOBackend;
+
+struct _Mp3IO
+{
+    int fd;
+    off_t size;
+    const Mp3IOBackend *backend;
+    const unsigned char *map; /* set by backends that expose the file in memory */
+};
+
+/* Ignore $MP3_TAG_IO=mmap from now on; call before starting threads */
+void mp3io_disable_mmap (void);
+
+/* flags as for open(2): O_RDONLY or O_RDWR */
+Status mp3io_open (Mp3IO *io, const char *path, int flags);
+/* Same for an already open regular file, e.g. from mkostemp(); io owns fd
+   afterwards, even on failure */
+Status mp3io_open_fd (Mp3IO *io, int fd);
+/* Fails when close(2) does, so writers learn about deferred write errors */
+Status mp3io_close (Mp3IO *io);
+
+/* Exactly len bytes at off, or p_failure */
+Status mp3io_read_full (Mp3IO *io, void *buf, size_t len, off_t off);
+/* Pointer to [off, off + len) when the backend has the file mapped, else NULL */
+const unsigned char *mp3io_peek (Mp3IO *io, off_t off, size_t len);
+
+/* Exactly len bytes at off, or p_failure */
+Status mp3io_write_full (Mp3IO *io, const void *buf, size_t len, off_t off);
+
+/* Copy [src_off, EOF) of src to dst at dst_off (dst NULL: read only),
+   feeding h when set */
+Status mp3io_copy_to_end (Mp3IO *src, off_t src_off, Mp3IO *dst, off_t dst_off, AudioHash *h);
+
+#endif
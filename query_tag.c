@@ -0,0 +1,637 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "query_tag.h"
+#include "export_tag.h"
+#include "types.h"
+
+/* Below this many rows per shard the thread start-up costs more than it saves */
+#define QUERY_MIN_SHARD_ROWS 65536
+#define QUERY_MAX_SHARDS 64
+
+typedef enum
+{
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE
+} FilterOp;
+
+typedef enum
+{
+    Q_LIST,
+    Q_COUNT,
+    Q_DISTINCT
+} QueryMode;
+
+/* One compiled "FIELD<op>VALUE" predicate */
+typedef struct
+{
+    const ColDirEntry *col;
+    FilterOp op;
+    const char *sval;
+    uint64_t nval;
+    uint32_t code_lo;   /* dict columns: codes in [code_lo, code_hi) match ... */
+    uint32_t code_hi;
+    int code_invert;    /* ... or do not match, for != */
+} Filter;
+
+/* Work for one thread: a contiguous row range of the index */
+typedef struct
+{
+    const TagIndex *idx;
+    const Filter *filters;
+    int nfilters;
+    uint64_t begin;
+    uint64_t end;
+    const ColDirEntry *group_dict; /* group-by dict column, counted in the shard */
+    uint64_t *group_counts;
+    int collect_rows;
+    uint64_t *rows;
+    size_t nrows;
+    size_t cap;
+    uint64_t matched;
+    Status st;
+} Shard;
+
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+/* Column payload accessors */
+static const unsigned char *col_data(const TagIndex *idx, const ColDirEntry *c)
+{
+    return idx->base + c->offset;
+}
+
+static const unsigned char *dict_table(const TagIndex *idx, const ColDirEntry *c)
+{
+    return col_data(idx, c) + align8(idx->row_count * sizeof(uint32_t));
+}
+
+/* String i of an offsets table holding n strings */
+static const char *string_at(const unsigned char *table, uint64_t n, uint64_t i)
+{
+    const uint64_t *offs = (const uint64_t *)table;
+    return (const char *)(table + (n + 1) * sizeof(uint64_t) + offs[i]);
+}
+
+/* Bytes used by an offsets table of n strings, including its padding */
+static uint64_t string_table_size(const unsigned char *table, uint64_t n)
+{
+    return align8((n + 1) * sizeof(uint64_t) + ((const uint64_t *)table)[n]);
+}
+
+static const char *dict_string(const TagIndex *idx, const ColDirEntry *c, uint32_t code)
+{
+    return string_at(dict_table(idx, c), c->dict_count, code);
+}
+
+const char *cell_string(const TagIndex *idx, const ColDirEntry *c, uint64_t row)
+{
+    if (c->kind == COL_STRING)
+        return string_at(col_data(idx, c), idx->row_count, row);
+    if (c->kind == COL_DICT)
+    {
+        uint32_t code = ((const uint32_t *)col_data(idx, c))[row];
+        return code == COL_DICT_ABSENT ? "" : dict_string(idx, c, code);
+    }
+    return NULL;
+}
+
+uint64_t cell_number(const TagIndex *idx, const ColDirEntry *c, uint64_t row)
+{
+    if (c->kind == COL_U32)
+        return ((const uint32_t *)col_data(idx, c))[row];
+    if (c->kind == COL_U64)
+        return ((const uint64_t *)col_data(idx, c))[row];
+    return 0;
+}
+
+static int is_numeric(const ColDirEntry *c)
+{
+    return c->kind == COL_U32 || c->kind == COL_U64;
+}
+
+int cell_absent(const TagIndex *idx, const ColDirEntry *c, uint64_t row)
+{
+    const unsigned char *data = col_data(idx, c);
+    switch (c->kind)
+    {
+    case COL_U32:
+        return ((const uint32_t *)data)[row] == COL_U32_ABSENT;
+    case COL_DICT:
+        return ((const uint32_t *)data)[row] == COL_DICT_ABSENT;
+    case COL_STRING:
+    {
+        const unsigned char *bits = data + string_table_size(data, idx->row_count);
+        return (bits[row / 8] >> (row % 8)) & 1;
+    }
+    }
+    return 0;
+}
+
+/* Check an offsets table of n strings fits in len bytes */
+static int string_table_ok(const unsigned char *table, uint64_t n, uint64_t len)
+{
+    if ((n + 1) * sizeof(uint64_t) > len)
+        return 0;
+    const uint64_t *offs = (const uint64_t *)table;
+    if (offs[n] > len - (n + 1) * sizeof(uint64_t))
+        return 0;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (offs[i] > offs[i + 1])
+            return 0;
+    }
+    return 1;
+}
+
+Status open_tag_index(const char *path, TagIndex *idx)
+{
+    if (!path || !idx)
+        return p_failure;
+    memset(idx, 0, sizeof(*idx));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return p_failure;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ColFileHeader))
+    {
+        close(fd);
+        return p_failure;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return p_failure;
+    idx->base = base;
+    idx->map_size = st.st_size;
+    idx->hdr = (const ColFileHeader *)base;
+    idx->dir = (const ColDirEntry *)(idx->base + sizeof(ColFileHeader));
+    idx->row_count = idx->hdr->row_count;
+
+    if (memcmp(idx->hdr->magic, COL_MAGIC, 8) != 0 ||
+        idx->hdr->endian != COL_ENDIAN_MARK ||
+        idx->hdr->version != COL_FORMAT_VERSION ||
+        sizeof(ColFileHeader) + (uint64_t)idx->hdr->column_count * sizeof(ColDirEntry) > idx->map_size)
+    {
+        close_tag_index(idx);
+        return p_failure;
+    }
+
+    /* validate every column so later accessors need no bounds checks */
+    for (uint32_t i = 0; i < idx->hdr->column_count; ++i)
+    {
+        const ColDirEntry *c = &idx->dir[i];
+        uint64_t rows = idx->row_count;
+        int ok = c->offset <= idx->map_size && c->length <= idx->map_size - c->offset && (c->offset & 7) == 0;
+        if (ok && c->kind == COL_U32)
+            ok = rows * sizeof(uint32_t) <= c->length;
+        else if (ok && c->kind == COL_U64)
+            ok = rows * sizeof(uint64_t) <= c->length;
+        else if (ok && c->kind == COL_STRING)
+            ok = string_table_ok(col_data(idx, c), rows, c->length) &&
+                 string_table_size(col_data(idx, c), rows) + (rows + 7) / 8 <= c->length;
+        else if (ok && c->kind == COL_DICT)
+        {
+            uint64_t codes_len = align8(rows * sizeof(uint32_t));
+            ok = codes_len <= c->length &&
+                 string_table_ok(dict_table(idx, c), c->dict_count, c->length - codes_len);
+            const uint32_t *codes = (const uint32_t *)col_data(idx, c);
+            for (uint64_t r = 0; ok && r < rows; ++r)
+                ok = codes[r] < c->dict_count || codes[r] == COL_DICT_ABSENT;
+        }
+        if (!ok)
+        {
+            close_tag_index(idx);
+            return p_failure;
+        }
+    }
+    return p_success;
+}
+
+Status close_tag_index(TagIndex *idx)
+{
+    if (!idx)
+        return p_failure;
+    if (idx->base)
+        munmap(idx->base, idx->map_size);
+    memset(idx, 0, sizeof(*idx));
+    return p_success;
+}
+
+const ColDirEntry *find_column(const TagIndex *idx, const char *name)
+{
+    if (strnlen(name, sizeof(idx->dir[0].name) + 1) > sizeof(idx->dir[0].name))
+        return NULL;
+    for (uint32_t i = 0; i < idx->hdr->column_count; ++i)
+    {
+        if (strncmp(idx->dir[i].name, name, sizeof(idx->dir[i].name)) == 0)
+            return &idx->dir[i];
+    }
+    return NULL;
+}
+
+/* First dictionary code whose string is >= value (or > value when upper is set) */
+static uint32_t dict_bound(const TagIndex *idx, const ColDirEntry *c, const char *value, int upper)
+{
+    uint32_t lo = 0, hi = c->dict_count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(dict_string(idx, c, mid), value);
+        if (cmp < 0 || (upper && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Parse "FIELD<op>VALUE" and resolve it against the index */
+static Status compile_filter(const TagIndex *idx, const char *arg, Filter *f, FILE *out)
+{
+    memset(f, 0, sizeof(*f));
+    size_t name_len = strcspn(arg, "!<>=");
+    /* names fill up to the whole (NUL padded) directory field, e.g. "filesize" */
+    if (arg[name_len] == '\0' || name_len == 0 || name_len > sizeof(f->col->name))
+    {
+        fprintf(out, "❌ERROR: Unable to parse filter \"%s\".\n", arg);
+        return p_failure;
+    }
+    char name[sizeof(f->col->name) + 1] = {0};
+    memcpy(name, arg, name_len);
+    const char *p = arg + name_len;
+    if (strncmp(p, "!=", 2) == 0)
+        f->op = OP_NE, p += 2;
+    else if (strncmp(p, "<=", 2) == 0)
+        f->op = OP_LE, p += 2;
+    else if (strncmp(p, ">=", 2) == 0)
+        f->op = OP_GE, p += 2;
+    else if (*p == '<')
+        f->op = OP_LT, p += 1;
+    else if (*p == '>')
+        f->op = OP_GT, p += 1;
+    else if (*p == '=')
+        f->op = OP_EQ, p += (p[1] == '=') ? 2 : 1;
+    else
+    {
+        fprintf(out, "❌ERROR: Unable to parse filter \"%s\".\n", arg);
+        return p_failure;
+    }
+
+    f->col = find_column(idx, name);
+    if (!f->col)
+    {
+        fprintf(out, "❌ERROR: Unknown field %s.\n", name);
+        return p_failure;
+    }
+    f->sval = p;
+    if (is_numeric(f->col))
+    {
+        /* digits only: strtoull alone would take "abc" as 0, "-1" as a huge
+           value and "5x" as 5 */
+        char *end;
+        errno = 0;
+        f->nval = strtoull(p, &end, 10);
+        if (*p < '0' || *p > '9' || *end != '\0' || errno == ERANGE)
+        {
+            fprintf(out, "❌ERROR: Unable to parse filter \"%s\".\n", arg);
+            return p_failure;
+        }
+    }
+
+    if (f->col->kind == COL_DICT)
+    {
+        /* sorted dictionary: every predicate becomes a code range */
+        uint32_t lb = dict_bound(idx, f->col, p, 0);
+        uint32_t ub = dict_bound(idx, f->col, p, 1);
+        uint32_t n = f->col->dict_count;
+        switch (f->op)
+        {
+        case OP_EQ: f->code_lo = lb; f->code_hi = ub; break;
+        case OP_NE: f->code_lo = lb; f->code_hi = ub; f->code_invert = 1; break;
+        case OP_LT: f->code_lo = 0; f->code_hi = lb; break;
+        case OP_LE: f->code_lo = 0; f->code_hi = ub; break;
+        case OP_GT: f->code_lo = ub; f->code_hi = n; break;
+        case OP_GE: f->code_lo = lb; f->code_hi = n; break;
+        }
+    }
+    return p_success;
+}
+
+static int compare_matches(int cmp, FilterOp op)
+{
+    switch (op)
+    {
+    case OP_EQ: return cmp == 0;
+    case OP_NE: return cmp != 0;
+    case OP_LT: return cmp < 0;
+    case OP_LE: return cmp <= 0;
+    case OP_GT: return cmp > 0;
+    case OP_GE: return cmp >= 0;
+    }
+    return 0;
+}
+
+static int row_matches(const TagIndex *idx, const Filter *filters, int nfilters, uint64_t row)
+{
+    for (int i = 0; i < nfilters; ++i)
+    {
+        const Filter *f = &filters[i];
+        int ok;
+        /* an absent value matches no comparison, not even != */
+        if (cell_absent(idx, f->col, row))
+            ok = 0;
+        else if (f->col->kind == COL_DICT)
+        {
+            uint32_t code = ((const uint32_t *)col_data(idx, f->col))[row];
+            ok = (code >= f->code_lo && code < f->code_hi) != f->code_invert;
+        }
+        else if (is_numeric(f->col))
+        {
+            uint64_t v = cell_number(idx, f->col, row);
+            ok = compare_matches((v > f->nval) - (v < f->nval), f->op);
+        }
+        else
+        {
+            ok = compare_matches(strcmp(cell_string(idx, f->col, row), f->sval), f->op);
+        }
+        if (!ok)
+            return 0;
+    }
+    return 1;
+}
+
+static void *run_shard(void *arg)
+{
+    Shard *s = arg;
+    const uint32_t *gcodes = s->group_dict ? (const uint32_t *)col_data(s->idx, s->group_dict) : NULL;
+    s->st = p_success;
+    for (uint64_t r = s->begin; r < s->end; ++r)
+    {
+        if (!row_matches(s->idx, s->filters, s->nfilters, r))
+            continue;
+        s->matched++;
+        if (gcodes)
+        {
+            /* absent rows are counted in the extra slot after the dictionary */
+            uint32_t code = gcodes[r];
+            s->group_counts[code == COL_DICT_ABSENT ? s->group_dict->dict_count : code]++;
+        }
+        if (s->collect_rows)
+        {
+            if (s->nrows >= s->cap)
+            {
+                s->cap = s->cap ? s->cap * 2 : 1024;
+                uint64_t *tmp = realloc(s->rows, s->cap * sizeof(uint64_t));
+                if (!tmp)
+                {
+                    s->st = p_failure;
+                    return NULL;
+                }
+                s->rows = tmp;
+            }
+            s->rows[s->nrows++] = r;
+        }
+    }
+    return NULL;
+}
+
+/* qsort_r comparator for grouping rows of a non-dictionary column */
+static int cmp_rows_by_col(const void *a, const void *b, void *arg)
+{
+    void **ctx = arg;
+    const TagIndex *idx = ctx[0];
+    const ColDirEntry *c = ctx[1];
+    uint64_t ra = *(const uint64_t *)a, rb = *(const uint64_t *)b;
+    if (is_numeric(c))
+    {
+        uint64_t va = cell_number(idx, c, ra), vb = cell_number(idx, c, rb);
+        return (va > vb) - (va < vb);
+    }
+    /* absent sorts last, like COL_U32_ABSENT does */
+    int aa = cell_absent(idx, c, ra), ab = cell_absent(idx, c, rb);
+    if (aa || ab)
+        return aa - ab;
+    return strcmp(cell_string(idx, c, ra), cell_string(idx, c, rb));
+}
+
+static void print_group(FILE *out, const TagIndex *idx, const ColDirEntry *c, uint64_t row,
+                        uint64_t count, QueryMode mode)
+{
+    if (cell_absent(idx, c, row))
+        fprintf(out, "-");
+    else if (is_numeric(c))
+        fprintf(out, "%llu", (unsigned long long)cell_number(idx, c, row));
+    else
+        fprintf(out, "%s", cell_string(idx, c, row));
+    if (mode == Q_COUNT)
+        fprintf(out, "\t%llu", (unsigned long long)count);
+    fprintf(out, "\n");
+}
+
+/*
+ * args: [count FIELD | distinct FIELD] [FIELD<op>VALUE ...]
+ * Filters are ANDed.  Without count/distinct the matching paths are listed.
+ */
+Status run_query(const char *index_path, char *args[], FILE *out)
+{
+    TagIndex idx;
+    if (open_tag_index(index_path, &idx) != p_success)
+    {
+        fprintf(out, "❌ERROR: %s is not a valid tag index.\n", index_path);
+        return p_failure;
+    }
+
+    QueryMode mode = Q_LIST;
+    const ColDirEntry *group = NULL;
+    int ai = 0;
+    if (args[0] && (strcmp(args[0], "count") == 0 || strcmp(args[0], "distinct") == 0))
+    {
+        mode = (args[0][0] == 'c') ? Q_COUNT : Q_DISTINCT;
+        group = args[1] ? find_column(&idx, args[1]) : NULL;
+        if (!group)
+        {
+            fprintf(out, "❌ERROR: Unknown field %s.\n", args[1] ? args[1] : "(none)");
+            close_tag_index(&idx);
+            return p_failure;
+        }
+        ai = 2;
+    }
+    const ColDirEntry *path_col = find_column(&idx, "path");
+
+    int nfilters = 0;
+    while (args[ai + nfilters])
+        nfilters++;
+    Filter *filters = calloc(nfilters ? nfilters : 1, sizeof(Filter));
+    Shard shards[QUERY_MAX_SHARDS];
+    memset(shards, 0, sizeof(shards));
+    uint64_t *totals = NULL;
+    uint64_t *rows = NULL;
+    Status st = p_failure;
+    if (!filters)
+        goto out;
+    for (int i = 0; i < nfilters; ++i)
+    {
+        if (compile_filter(&idx, args[ai + i], &filters[i], out) != p_success)
+            goto out;
+    }
+
+    /* split rows into contiguous shards, one thread each */
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t nshards = idx.row_count / QUERY_MIN_SHARD_ROWS;
+    if (nshards > (uint64_t)(ncpu > 0 ? ncpu : 1))
+        nshards = ncpu > 0 ? ncpu : 1;
+    if (nshards > QUERY_MAX_SHARDS)
+        nshards = QUERY_MAX_SHARDS;
+    if (nshards == 0)
+        nshards = 1;
+
+    const ColDirEntry *group_dict = (group && group->kind == COL_DICT) ? group : NULL;
+    pthread_t threads[QUERY_MAX_SHARDS];
+    int started[QUERY_MAX_SHARDS] = {0};
+    for (uint64_t i = 0; i < nshards; ++i)
+    {
+        Shard *s = &shards[i];
+        s->idx = &idx;
+        s->filters = filters;
+        s->nfilters = nfilters;
+        s->begin = idx.row_count * i / nshards;
+        s->end = idx.row_count * (i + 1) / nshards;
+        s->group_dict = group_dict;
+        s->collect_rows = (mode == Q_LIST) || (group && !group_dict);
+        s->st = p_failure;
+        if (group_dict)
+        {
+            s->group_counts = calloc((size_t)group_dict->dict_count + 1, sizeof(uint64_t));
+            if (!s->group_counts)
+                continue;
+        }
+        if (nshards == 1)
+            run_shard(s);
+        else if (pthread_create(&threads[i], NULL, run_shard, s) == 0)
+            started[i] = 1;
+        else
+            run_shard(s);
+    }
+    for (uint64_t i = 0; i < nshards; ++i)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+    for (uint64_t i = 0; i < nshards; ++i)
+    {
+        if (shards[i].st != p_success)
+        {
+            fprintf(out, "❌ERROR: Out of memory while evaluating query.\n");
+            goto out;
+        }
+    }
+
+    uint64_t matched = 0;
+    size_t nrows = 0;
+    for (uint64_t i = 0; i < nshards; ++i)
+    {
+        matched += shards[i].matched;
+        nrows += shards[i].nrows;
+    }
+
+    if (group_dict)
+    {
+        /* merge per-shard counts; code order is already value order */
+        uint64_t nslots = (uint64_t)group_dict->dict_count + 1;
+        totals = calloc(nslots, sizeof(uint64_t));
+        if (!totals)
+            goto out;
+        for (uint64_t i = 0; i < nshards; ++i)
+            for (uint64_t c = 0; c < nslots; ++c)
+                totals[c] += shards[i].group_counts[c];
+        for (uint64_t c = 0; c < nslots; ++c)
+        {
+            if (!totals[c])
+                continue;
+            /* the last slot holds rows without the frame */
+            if (c == group_dict->dict_count)
+                fprintf(out, "-");
+            else
+                fprintf(out, "%s", dict_string(&idx, group_dict, (uint32_t)c));
+            if (mode == Q_COUNT)
+                fprintf(out, "\t%llu", (unsigned long long)totals[c]);
+            fprintf(out, "\n");
+        }
+    }
+    else
+    {
+        /* shards are contiguous, so concatenating keeps row order */
+        rows = malloc((nrows ? nrows : 1) * sizeof(uint64_t));
+        if (!rows)
+            goto out;
+        size_t k = 0;
+        for (uint64_t i = 0; i < nshards; ++i)
+        {
+            if (shards[i].nrows)
+                memcpy(rows + k, shards[i].rows, shards[i].nrows * sizeof(uint64_t));
+            k += shards[i].nrows;
+        }
+
+        if (mode == Q_LIST)
+        {
+            for (size_t i = 0; i < nrows; ++i)
+                fprintf(out, "%s\n", path_col ? cell_string(&idx, path_col, rows[i]) : "");
+        }
+        else
+        {
+            void *ctx[2] = {&idx, (void *)group};
+            qsort_r(rows, nrows, sizeof(uint64_t), cmp_rows_by_col, ctx);
+            size_t run = 0;
+            for (size_t i = 1; i <= nrows; ++i)
+            {
+                if (i == nrows || cmp_rows_by_col(&rows[run], &rows[i], ctx) != 0)
+                {
+                    print_group(out, &idx, group, rows[run], i - run, mode);
+                    run = i;
+                }
+            }
+        }
+    }
+    fprintf(out, "INFO: %llu of %llu rows matched\n",
+            (unsigned long long)matched, (unsigned long long)idx.row_count);
+    st = p_success;
+
+out:
+    for (int i = 0; i < QUERY_MAX_SHARDS; ++i)
+    {
+        free(shards[i].rows);
+        free(shards[i].group_counts);
+    }
+    free(totals);
+    free(rows);
+    free(filters);
+    close_tag_index(&idx);
+    return st;
+}
+
+/* CLI: -q <index_file> [count|distinct FIELD] [FIELD<op>VALUE ...] */
+Status query_tags(char *argv[])
+{
+    if (argv[2] == NULL)
+    {
+        printf("➡️INFO: For Querying an index -> ./mp3_tag_reader -q <index_file> [count|distinct FIELD] [FIELD<op>VALUE ...]\n");
+        return p_failure;
+    }
+    return run_query(argv[2], argv + 3, stdout);
+}
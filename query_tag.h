@@ -0,0 +1,34 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "types.h"
+#include "export_tag.h"
+#include <stdio.h>
+#include <stdint.h>
+
+/* A columnar index file (see export_tag.h) mapped read-only */
+typedef struct _TagIndex
+{
+    unsigned char *base;
+    size_t map_size;
+    const ColFileHeader *hdr;
+    const ColDirEntry *dir;
+    uint64_t row_count;
+} TagIndex;
+
+Status open_tag_index (const char *path, TagIndex *idx);
+Status close_tag_index (TagIndex *idx);
+const ColDirEntry *find_column (const TagIndex *idx, const char *name);
+
+/* Cell accessors; rows must be < row_count.  cell_string is for string and
+   dict columns (an absent cell reads as ""), cell_number for u32/u64 ones */
+const char *cell_string (const TagIndex *idx, const ColDirEntry *c, uint64_t row);
+uint64_t cell_number (const TagIndex *idx, const ColDirEntry *c, uint64_t row);
+/* Non-zero if the file behind row had no value for this column */
+int cell_absent (const TagIndex *idx, const ColDirEntry *c, uint64_t row);
+
+/* Run one query; args is the NULL terminated list after the index path */
+Status run_query (const char *index_path, char *args[], FILE *out);
+Status query_tags (char* argv[]);
+
+#endif
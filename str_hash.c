@@ -0,0 +1,14 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include "str_hash.h"
+
+uint32_t str_hash(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,10 @@
+#ifndef STR_HASH_H
+#define STR_HASH_H
+
+#include <stdint.h>
+
+/* FNV-1a of a NUL terminated string: dictionary sets, path caches and
+   lock stripes all bucket strings with it */
+uint32_t str_hash (const char *s);
+
+#endif
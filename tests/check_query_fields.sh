@@ -0,0 +1,29 @@
+#!/bin/sh
+# Runs a filter and a count over every FIELD that --help advertises for -q.
+# usage: tests/check_query_fields.sh path/to/mp3_tag_reader
+# The binary is required: a default would silently test a stale build.
+[ $# -eq 1 ] || { echo "usage: $0 path/to/mp3_tag_reader" >&2; exit 2; }
+BIN=$1
+[ -x "$BIN" ] || { echo "FAIL: $BIN is not executable" >&2; exit 2; }
+DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$DIR"' EXIT
+export MP3_TAG_SOCKET=
+
+# ID3v2.3 tag with one TIT2 frame ("x"), followed by a few audio bytes
+printf 'ID3\003\000\000\000\000\000\014TIT2\000\000\000\002\000\000\000xAUDIO' > "$DIR/a.mp3"
+"$BIN" -x "$DIR/idx" "$DIR/a.mp3" > /dev/null || { echo "FAIL: export"; exit 1; }
+
+LINE=$("$BIN" --help | grep 'FIELD is a frame ID')
+FIELDS="$(echo "$LINE" | sed 's/.*(\(.*\)).*/\1/') $(echo "$LINE" | sed 's/.*) or //' | tr '/' ' ')"
+[ -n "$FIELDS" ] || { echo "FAIL: no FIELD list in --help"; exit 1; }
+
+status=0
+for f in $FIELDS; do
+    for q in "count $f" "$f>=0"; do
+        if ! "$BIN" -q "$DIR/idx" $q > "$DIR/out" 2>&1 || grep -q 'ERROR' "$DIR/out"; then
+            echo "FAIL: -q idx $q"; cat "$DIR/out"; status=1
+        fi
+    done
+done
+[ $status -eq 0 ] && echo "OK: $FIELDS"
+exit $status
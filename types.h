@@ -17,6 +17,11 @@ typedef enum
 {
     p_view,
     p_edit,
+    p_export,
+    p_query,
+    p_daemon,
+    p_watch,
+    p_rollback,
     p_help,
     p_unsupported
 } OperationType;
@@ -1,36 +1,22 @@
 #define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #include "view_tag.h"
+#include "mp3_io.h"
+#include "frame_codec.h"
 #include "edit_tag.h"
 #include "types.h"
 
-/* Helper to convert 4-byte syncsafe (used in ID3 header) to int */
-static uint syncsafe_to_int(const unsigned char s[4])
+/* Read ID3 header and all frames in the tag area (v2.3, v2.4 frame sizes) */
+Status read_id3_tag(Mp3IO *io, ID3Tag *tag)
 {
-    return ((s[0] & 0x7F) << 21) |
-           ((s[1] & 0x7F) << 14) |
-           ((s[2] & 0x7F) << 7) |
-           ((s[3] & 0x7F));
-}
-
-/* Convert 4-byte big-endian to host uint */
-static uint be32_to_uint(const unsigned char b[4])
-{
-    return ((uint)b[0] << 24) | ((uint)b[1] << 16) | ((uint)b[2] << 8) | (uint)b[3];
-}
-
-/* Read ID3 header and all frames in the tag area (v2.3) */
-static Status read_id3_tag(FILE *f, ID3Tag *tag)
-{
-    if (!f || !tag)
-        return p_failure;
-
-    if (fseek(f, 0, SEEK_SET) != 0)
+    if (!io || !tag)
         return p_failure;
 
-    if (fread(tag->header, 1, 10, f) != 10)
+    if (mp3io_read_full(io, tag->header, 10, 0) != p_success)
         return p_failure;
 
     if (strncmp((char *)tag->header, "ID3", 3) != 0)
@@ -38,25 +24,30 @@ static Status read_id3_tag(FILE *f, ID3Tag *tag)
 
     unsigned char ver_major = tag->header[3];
     unsigned char ver_rev = tag->header[4];
-    /* we currently support v2.3.x */
-    if (ver_major != 3)
-    {
-        /* still continue but warn; many files are 2.3 */
-        /* we won't hard-fail, but parsing assumes v2.3 frames */
-    }
+    /* v2.3 and v2.4 share the frame layout; only the frame size encoding
+       differs.  Frame flags are decoded lazily by frame_content() */
 
     unsigned char size_bytes[4];
     memcpy(size_bytes, tag->header + 6, 4);
     tag->tag_size = syncsafe_to_int(size_bytes);
+    if ((off_t)tag->tag_size > io->size - 10)
+        return p_failure;
 
-    /* tag_size is size of tag after header; read the tag area */
-    unsigned char *tag_buf = malloc(tag->tag_size);
+    /* tag_size is size of tag after header; parse it in place when the
+       backend has the file mapped, otherwise read the tag area */
+    unsigned char *tag_copy = NULL;
+    const unsigned char *tag_buf = mp3io_peek(io, 10, tag->tag_size);
     if (!tag_buf)
-        return p_failure;
-    if (fread(tag_buf, 1, tag->tag_size, f) != tag->tag_size)
     {
-        free(tag_buf);
-        return p_failure;
+        tag_copy = malloc(tag->tag_size ? tag->tag_size : 1);
+        if (!tag_copy)
+            return p_failure;
+        if (mp3io_read_full(io, tag_copy, tag->tag_size, 10) != p_success)
+        {
+            free(tag_copy);
+            return p_failure;
+        }
+        tag_buf = tag_copy;
     }
 
     /* Parse frames: frames start at offset 0 of tag_buf for v2.3 (no extended header handling) */
@@ -64,9 +55,10 @@ static Status read_id3_tag(FILE *f, ID3Tag *tag)
     int capacity = 16;
     tag->frames = calloc(capacity, sizeof(Frame));
     tag->frame_count = 0;
+    memset(tag->frame_slot, 0, sizeof(tag->frame_slot));
     while (offset + 10 <= tag->tag_size)
     {
-        unsigned char *p = tag_buf + offset;
+        const unsigned char *p = tag_buf + offset;
         /* If frame id is zero or non-printable, it's padding -> break */
         if (p[0] == 0)
             break;
@@ -74,8 +66,9 @@ static Status read_id3_tag(FILE *f, ID3Tag *tag)
         memset(&fframe, 0, sizeof(fframe));
         memcpy(fframe.id, p, 4);
         fframe.id[4] = '\0';
-        fframe.size = be32_to_uint(p + 4);
+        fframe.size = frame_size_from_bytes(ver_major, p + 4);
         memcpy(fframe.flags, p + 8, 2);
+        uint packed_id = be32_to_uint(p);
 
         /* Sanity check */
         if (fframe.size > tag->tag_size - offset - 10)
@@ -86,7 +79,7 @@ static Status read_id3_tag(FILE *f, ID3Tag *tag)
         fframe.data = malloc(fframe.size);
         if (!fframe.data)
         {
-            free(tag_buf);
+            free(tag_copy);
             return p_failure;
         }
         if (fframe.size > 0)
@@ -99,16 +92,19 @@ static Status read_id3_tag(FILE *f, ID3Tag *tag)
             Frame *tmp = realloc(tag->frames, capacity * sizeof(Frame));
             if (!tmp)
             {
-                free(tag_buf);
+                free(tag_copy);
                 return p_failure;
             }
             tag->frames = tmp;
         }
+        int type = frame_type_by_id(packed_id);
+        if (type >= 0 && tag->frame_slot[type] == 0)
+            tag->frame_slot[type] = tag->frame_count + 1;
         tag->frames[tag->frame_count++] = fframe;
 
         offset += 10 + fframe.size;
     }
-    free(tag_buf);
+    free(tag_copy);
     return p_success;
 }
 
@@ -119,23 +115,22 @@ Status free_id3_tag(ID3Tag *tag)
         return p_failure;
     for (int i = 0; i < tag->frame_count; ++i)
     {
+        frame_content_free(&tag->frames[i]);
         free(tag->frames[i].data);
     }
     free(tag->frames);
     tag->frames = NULL;
     tag->frame_count = 0;
+    memset(tag->frame_slot, 0, sizeof(tag->frame_slot));
     return p_success;
 }
 
-/* Find frame pointer by ID */
-static Frame *find_frame(ID3Tag *tag, const char *id)
+/* Frame of a registered type, looked up through the slot table filled while parsing */
+Frame *tag_frame(ID3Tag *tag, int type)
 {
-    for (int i = 0; i < tag->frame_count; ++i)
-    {
-        if (strncmp(tag->frames[i].id, id, 4) == 0)
-            return &tag->frames[i];
-    }
-    return NULL;
+    if (!tag || type < 0 || type >= FRAME_TYPE_COUNT || tag->frame_slot[type] == 0)
+        return NULL;
+    return &tag->frames[tag->frame_slot[type] - 1];
 }
 
 /* Extract text from a text frame: first byte is encoding (0 = ISO-8859-1, 1 = UTF-16) */
@@ -146,7 +141,7 @@ static char *extract_text_from_frame(Frame *f)
     unsigned char enc = f->data[0];
     size_t text_len = (f->size >= 1) ? (f->size - 1) : 0;
     if (text_len == 0)
-        return NULL;
+        return strdup(""); /* present but empty, unlike a missing frame */
 
     char *out = malloc(text_len + 1);
     if (!out)
@@ -195,7 +190,7 @@ static char *extract_comment_from_frame(Frame *f)
         return NULL;
     unsigned char enc = f->data[0];
     if (f->size <= 4)
-        return NULL; /* no space for lang and text */
+        return strdup(""); /* no space for lang and text */
     size_t pos = 1;
     char lang[4] = {0};
     memcpy(lang, f->data + pos, 3);
@@ -208,7 +203,7 @@ static char *extract_comment_from_frame(Frame *f)
     /* after desc_end + 1, the rest is comment text */
     size_t text_start = desc_end + 1;
     if (text_start >= f->size)
-        return NULL;
+        return strdup("");
     size_t text_len = f->size - text_start;
     char *out = malloc(text_len + 1);
     if (!out)
@@ -218,71 +213,111 @@ static char *extract_comment_from_frame(Frame *f)
     return out;
 }
 
-/* Print frames in the required order and formatting to match sample output */
-Status view_tag(char *argv[], const char *filename)
+/* Decode the frames the tool understands into plain strings */
+Status decode_tag_info(ID3Tag *tag, TagInfo *info)
 {
-    FILE *f = fopen(filename, "rb");
-    if (!f)
-    {
-        printf("❌ERROR: Unable to Open the %s file.\n", filename);
-        printf("➡️INFO: For Viewing the Tags -> ./mp3_tag_reader -v <file_name.mp3>\n");
+    if (!tag || !info)
         return p_failure;
+    memset(info, 0, sizeof(*info));
+    info->ver_major = tag->header[3];
+    info->ver_rev = tag->header[4];
+    info->tag_size = tag->tag_size;
+
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        Frame *fr = tag_frame(tag, i);
+        if (!fr)
+            continue;
+        /* only requested frames are decompressed; encrypted ones stay empty */
+        Frame plain = *fr;
+        plain.data = (unsigned char *)frame_content(info->ver_major, fr, &plain.size);
+        if (!plain.data)
+            continue;
+        if (frame_types[i].decoder == FRAME_DECODE_COMMENT)
+            info->field[i] = extract_comment_from_frame(&plain);
+        else
+            info->field[i] = extract_text_from_frame(&plain);
     }
+    return p_success;
+}
+
+/* Open, parse and decode a file in one go (used by the bulk modes) */
+Status load_tag_info(const char *filename, TagInfo *info)
+{
+    Mp3IO io;
+    if (mp3io_open(&io, filename, O_RDONLY) != p_success)
+        return p_failure;
 
     ID3Tag tag = {0};
-    if (read_id3_tag(f, &tag) != p_success)
+    if (read_id3_tag(&io, &tag) != p_success)
     {
-        printf("❌ERROR: The file Signature is not matching with that of a '.mp3' file.\n");
-        fclose(f);
+        free_id3_tag(&tag);
+        mp3io_close(&io);
         return p_failure;
     }
+    Status st = decode_tag_info(&tag, info);
+    free_id3_tag(&tag);
+    mp3io_close(&io);
+    return st;
+}
 
+/* Free decoded strings */
+Status free_tag_info(TagInfo *info)
+{
+    if (!info)
+        return p_failure;
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+        free(info->field[i]);
+    memset(info, 0, sizeof(*info));
+    return p_success;
+}
+
+/* Print decoded frames in the required order and formatting to match sample output */
+void print_tag_info(const TagInfo *info)
+{
     /* Print header info like sample */
-    unsigned char ver_major = tag.header[3];
-    unsigned char ver_rev = tag.header[4];
     printf("                  MP3 TAG READER & EDITOR                   \n");
     printf("============================================================\n");
-    printf("Version ID : %u.%u\n", ver_major, ver_rev);
+    printf("Version ID : %u.%u\n", info->ver_major, info->ver_rev);
     printf("------------------------------------------------------------\n");
 
-    /* Extract each frame */
-    Frame *f_title = find_frame(&tag, "TIT2");
-    Frame *f_artist = find_frame(&tag, "TPE1");
-    Frame *f_album = find_frame(&tag, "TALB");
-    Frame *f_year = find_frame(&tag, "TYER");
-    // Frame *f_track = find_frame(&tag, "TRCK"); /* track sample shows Track */
-    Frame *f_genre = find_frame(&tag, "TCON");
-    Frame *f_comment = find_frame(&tag, "COMM");
-
-    char *s;
-    s = f_title ? extract_text_from_frame(f_title) : NULL;
-    printf("Title      : %s\n", s ? s : "");
-    free(s);
-
-    s = f_album ? extract_text_from_frame(f_album) : NULL;
-    printf("Album      : %s\n", s ? s : "");
-    free(s);
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        printf("%-11s: %s\n", frame_types[i].name, info->field[i] ? info->field[i] : "");
+    }
+    printf("\n");
 
-    s = f_year ? extract_text_from_frame(f_year) : NULL;
-    printf("Year       : %s\n", s ? s : "");
-    free(s);
+    printf("Extracting Album Art - Done✅\n");
+}
 
-    s = f_genre ? extract_text_from_frame(f_genre) : NULL;
-    printf("Genre      : %s\n", s ? s : "");
-    free(s);
+/* Read a file and print its frames */
+Status view_tag(char *argv[], const char *filename)
+{
+    Mp3IO io;
+    if (mp3io_open(&io, filename, O_RDONLY) != p_success)
+    {
+        printf("❌ERROR: Unable to Open the %s file.\n", filename);
+        printf("➡️INFO: For Viewing the Tags -> ./mp3_tag_reader -v <file_name.mp3>\n");
+        return p_failure;
+    }
 
-    s = f_artist ? extract_text_from_frame(f_artist) : NULL;
-    printf("Artist     : %s\n", s ? s : "");
-    free(s);
+    ID3Tag tag = {0};
+    if (read_id3_tag(&io, &tag) != p_success)
+    {
+        printf("❌ERROR: The file Signature is not matching with that of a '.mp3' file.\n");
+        free_id3_tag(&tag);
+        mp3io_close(&io);
+        return p_failure;
+    }
 
-    char *cmt = f_comment ? extract_comment_from_frame(f_comment) : NULL;
-    printf("Comment    : %s\n\n", cmt ? cmt : "");
-    free(cmt);
+    TagInfo info;
+    decode_tag_info(&tag, &info);
 
-    printf("Extracting Album Art - Done✅\n");
+    print_tag_info(&info);
 
+    free_tag_info(&info);
     free_id3_tag(&tag);
-    fclose(f);
+    mp3io_close(&io);
     return p_success;
 }
 
@@ -309,6 +344,26 @@ OperationType check_operation(char *argv[])
     {
         return p_edit;
     }
+    else if (strncmp(argv[1], "-x", 2) == 0)
+    {
+        return p_export;
+    }
+    else if (strncmp(argv[1], "-q", 2) == 0)
+    {
+        return p_query;
+    }
+    else if (strncmp(argv[1], "-d", 2) == 0)
+    {
+        return p_daemon;
+    }
+    else if (strncmp(argv[1], "-w", 2) == 0)
+    {
+        return p_watch;
+    }
+    else if (strncmp(argv[1], "-r", 2) == 0)
+    {
+        return p_rollback;
+    }
     else if (strncmp(argv[1], "--help", 6) == 0 || strncmp(argv[1], "-h", 2) == 0)
     {
         return p_help;
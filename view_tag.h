@@ -2,6 +2,8 @@
 #define VIEW_H
 
 #include "types.h"
+#include "frame_registry.h"
+#include "mp3_io.h"
 #include <stdio.h>
 
 typedef struct _Frame {
@@ -9,6 +11,9 @@ typedef struct _Frame {
     uint size;       /* frame size (big-endian in file; we'll store host order) */
     unsigned char flags[2];
     unsigned char *data; /* raw frame data (size bytes) */
+    unsigned char *content;      /* decoded payload, see frame_content() */
+    uint content_size;
+    unsigned char content_state; /* FrameContentState */
 } Frame;
 
 typedef struct _ID3Tag {
@@ -16,13 +21,28 @@ typedef struct _ID3Tag {
     uint tag_size;    /* size from header (syncsafe -> host) */
     Frame *frames;
     int frame_count;
+    int frame_slot[FRAME_TYPE_COUNT]; /* index + 1 of first frame of each registered type, 0 = absent */
 } ID3Tag;
 
+/* Decoded text of the registered frames, indexed by FrameTypeIndex (NULL when absent) */
+typedef struct _TagInfo {
+    char *field[FRAME_TYPE_COUNT];
+    unsigned char ver_major;
+    unsigned char ver_rev;
+    uint tag_size;
+} TagInfo;
+
 /* Parsing, printing helpers */
 Status read_and_validate_mp3_file (char* argv[], char *filename_out);
 OperationType check_operation (char* argv[]);
 Status view_tag (char* argv[], const char *filename);
 Status free_id3_tag(ID3Tag *tag);
+Status read_id3_tag(Mp3IO *io, ID3Tag *tag);
+Frame *tag_frame(ID3Tag *tag, int type);
+Status decode_tag_info(ID3Tag *tag, TagInfo *info);
+Status load_tag_info(const char *filename, TagInfo *info);
+Status free_tag_info(TagInfo *info);
+void print_tag_info(const TagInfo *info);
 
 #endif
 
@@ -0,0 +1,575 @@
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "watch_tag.h"
+#include "export_tag.h"
+#include "query_tag.h"
+#include "frame_registry.h"
+#include "str_hash.h"
+#include "types.h"
+
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_DELETE_SELF)
+
+/* One indexed file plus the stamp it was parsed at */
+typedef struct
+{
+    TagRecord rec;
+    struct timespec mtime;
+    off_t size;
+    unsigned seen;   /* generation of the last full scan that found it */
+} WatchEntry;
+
+typedef struct
+{
+    /* library: entries + open addressed path -> entry index + 1 */
+    WatchEntry *entries;
+    size_t count;
+    size_t cap;
+    size_t *slots;
+    size_t nslots;
+    size_t used_slots; /* live + tombstones */
+
+    /* paths with pending change events */
+    char **dirty;
+    size_t ndirty;
+    size_t dirty_cap;
+
+    /* inotify watch descriptor -> directory */
+    int ifd;
+    char **wd_path;
+    int wd_cap;
+
+    const char *root;
+    const char *index_path;
+    unsigned gen;
+    int need_rescan;
+    int need_watches;  /* events were dropped: the rescan must also watch new directories */
+} Watcher;
+
+#define SLOT_TOMB ((size_t)-1)
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_stop(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static long long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int is_mp3_name(const char *name)
+{
+    size_t n = strlen(name);
+    return n > 4 && strcasecmp(name + n - 4, ".mp3") == 0;
+}
+
+/* Slot holding path, or the empty slot where it would go */
+static size_t *lib_slot(Watcher *w, const char *path)
+{
+    size_t h = str_hash(path) & (w->nslots - 1);
+    size_t *tomb = NULL;
+    for (;;)
+    {
+        size_t *s = &w->slots[h];
+        if (*s == 0)
+            return tomb ? tomb : s;
+        if (*s == SLOT_TOMB)
+        {
+            if (!tomb)
+                tomb = s;
+        }
+        else if (strcmp(w->entries[*s - 1].rec.path, path) == 0)
+            return s;
+        h = (h + 1) & (w->nslots - 1);
+    }
+}
+
+static long lib_find(Watcher *w, const char *path)
+{
+    size_t *s = lib_slot(w, path);
+    return (*s && *s != SLOT_TOMB) ? (long)(*s - 1) : -1;
+}
+
+static Status lib_rehash(Watcher *w, size_t nslots)
+{
+    size_t *slots = calloc(nslots, sizeof(size_t));
+    if (!slots)
+        return p_failure;
+    free(w->slots);
+    w->slots = slots;
+    w->nslots = nslots;
+    w->used_slots = w->count;
+    for (size_t i = 0; i < w->count; ++i)
+        *lib_slot(w, w->entries[i].rec.path) = i + 1;
+    return p_success;
+}
+
+/* Takes ownership of e */
+static Status lib_insert(Watcher *w, WatchEntry *e)
+{
+    if ((w->used_slots + 1) * 2 > w->nslots &&
+        lib_rehash(w, (w->count + 1) * 4 > w->nslots ? w->nslots * 2 : w->nslots) != p_success)
+        return p_failure;
+    if (w->count >= w->cap)
+    {
+        size_t ncap = w->cap ? w->cap * 2 : 1024;
+        WatchEntry *tmp = realloc(w->entries, ncap * sizeof(WatchEntry));
+        if (!tmp)
+            return p_failure;
+        w->entries = tmp;
+        w->cap = ncap;
+    }
+    size_t *s = lib_slot(w, e->rec.path);
+    if (*s == 0)
+        w->used_slots++;
+    w->entries[w->count] = *e;
+    *s = ++w->count;
+    return p_success;
+}
+
+static void lib_remove(Watcher *w, long idx)
+{
+    *lib_slot(w, w->entries[idx].rec.path) = SLOT_TOMB;
+    free_tag_record(&w->entries[idx].rec);
+    size_t last = w->count - 1;
+    if ((size_t)idx != last)
+    {
+        w->entries[idx] = w->entries[last];
+        *lib_slot(w, w->entries[idx].rec.path) = idx + 1;
+    }
+    w->count--;
+}
+
+static void mark_dirty(Watcher *w, const char *path)
+{
+    if (w->ndirty >= w->dirty_cap)
+    {
+        size_t ncap = w->dirty_cap ? w->dirty_cap * 2 : 256;
+        char **tmp = realloc(w->dirty, ncap * sizeof(char *));
+        if (!tmp)
+        {
+            w->need_rescan = 1; /* fall back to the full scan */
+            return;
+        }
+        w->dirty = tmp;
+        w->dirty_cap = ncap;
+    }
+    char *copy = strdup(path);
+    if (!copy)
+    {
+        w->need_rescan = 1;
+        return;
+    }
+    w->dirty[w->ndirty++] = copy;
+}
+
+static void add_watch(Watcher *w, const char *dir)
+{
+    int wd = inotify_add_watch(w->ifd, dir, WATCH_MASK | IN_ONLYDIR);
+    if (wd < 0)
+    {
+        printf("⚠️WARNING: Unable to watch %s; relying on periodic rescans.\n", dir);
+        return;
+    }
+    if (wd >= w->wd_cap)
+    {
+        int ncap = w->wd_cap ? w->wd_cap : 64;
+        while (ncap <= wd)
+            ncap *= 2;
+        char **tmp = realloc(w->wd_path, ncap * sizeof(char *));
+        if (!tmp)
+            return;
+        memset(tmp + w->wd_cap, 0, (ncap - w->wd_cap) * sizeof(char *));
+        w->wd_path = tmp;
+        w->wd_cap = ncap;
+    }
+    free(w->wd_path[wd]);
+    w->wd_path[wd] = strdup(dir);
+}
+
+/*
+ * Walk dir recursively.  Files that are new or whose stamp changed are
+ * marked dirty, known files are stamped with the current generation.
+ * With add_watches set every directory found is also watched.
+ */
+static void scan_dir(Watcher *w, const char *dir, int add_watches)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+    if (add_watches)
+        add_watch(w, dir);
+
+    struct dirent *de;
+    char path[PATH_MAX];
+    while ((de = readdir(d)) != NULL)
+    {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        if (snprintf(path, sizeof(path), "%s/%s", dir, de->d_name) >= (int)sizeof(path))
+            continue;
+        struct stat st;
+        if (lstat(path, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            scan_dir(w, path, add_watches);
+        else if (S_ISREG(st.st_mode) && is_mp3_name(de->d_name))
+        {
+            long idx = lib_find(w, path);
+            if (idx >= 0)
+            {
+                WatchEntry *e = &w->entries[idx];
+                e->seen = w->gen;
+                if (e->size == st.st_size && e->mtime.tv_sec == st.st_mtim.tv_sec &&
+                    e->mtime.tv_nsec == st.st_mtim.tv_nsec)
+                    continue;
+            }
+            mark_dirty(w, path);
+        }
+    }
+    closedir(d);
+}
+
+/* Full mtime-diff scan: catches changes the event stream dropped and vanished files */
+static void rescan(Watcher *w, int add_watches)
+{
+    w->gen++;
+    scan_dir(w, w->root, add_watches);
+    for (size_t i = 0; i < w->count; ++i)
+    {
+        if (w->entries[i].seen != w->gen)
+            mark_dirty(w, w->entries[i].rec.path);
+    }
+    w->need_rescan = 0;
+    if (add_watches)
+        w->need_watches = 0;
+}
+
+/* Rebuild the TagRecord exported in row r; cols holds the frame columns in
+   FrameTypeIndex order */
+static Status record_from_index(const TagIndex *idx, const ColDirEntry *const cols[], uint64_t r,
+                                const char *path, TagRecord *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    if (!(rec->path = strdup(path)))
+        return p_failure;
+    for (int i = 0; i < FRAME_TYPE_COUNT; ++i)
+    {
+        if (cell_absent(idx, cols[i], r))
+            continue;
+        if (cols[i]->kind == COL_U32 || cols[i]->kind == COL_U64)
+        {
+            /* TYER is kept as a number: the text it came from was all digits */
+            char num[24];
+            snprintf(num, sizeof(num), "%llu", (unsigned long long)cell_number(idx, cols[i], r));
+            rec->info.field[i] = strdup(num);
+        }
+        else
+            rec->info.field[i] = strdup(cell_string(idx, cols[i], r));
+        if (!rec->info.field[i])
+        {
+            free_tag_record(rec);
+            return p_failure;
+        }
+    }
+    return p_success;
+}
+
+/*
+ * Start from the index a previous run left behind, so the first rescan
+ * only re-parses files whose size or mtime changed since.  An index this
+ * build cannot read, and rows outside root, are simply not used.
+ */
+static void seed_from_index(Watcher *w)
+{
+    TagIndex idx;
+    if (open_tag_index(w->index_path, &idx) != p_success)
+        return;
+    const ColDirEntry *path_col = find_column(&idx, "path");
+    const ColDirEntry *size_col = find_column(&idx, "filesize");
+    const ColDirEntry *mtime_col = find_column(&idx, "mtime");
+    const ColDirEntry *tag_col = find_column(&idx, "tagsize");
+    const ColDirEntry *ver_col = find_column(&idx, "version");
+    const ColDirEntry *cols[FRAME_TYPE_COUNT];
+    int ok = path_col && path_col->kind == COL_STRING &&
+             size_col && size_col->kind == COL_U64 &&
+             mtime_col && mtime_col->kind == COL_U64 &&
+             tag_col && tag_col->kind == COL_U32 &&
+             ver_col && ver_col->kind == COL_U32;
+    for (int i = 0; ok && i < FRAME_TYPE_COUNT; ++i)
+        ok = (cols[i] = find_column(&idx, frame_types[i].id)) != NULL;
+
+    size_t root_len = strlen(w->root);
+    size_t seeded = 0;
+    for (uint64_t r = 0; ok && r < idx.row_count; ++r)
+    {
+        const char *path = cell_string(&idx, path_col, r);
+        if (strncmp(path, w->root, root_len) != 0 || path[root_len] != '/' || lib_find(w, path) >= 0)
+            continue;
+        WatchEntry e;
+        memset(&e, 0, sizeof(e));
+        if (record_from_index(&idx, cols, r, path, &e.rec) != p_success)
+            break;
+        uint32_t ver = (uint32_t)cell_number(&idx, ver_col, r);
+        e.rec.info.ver_major = (unsigned char)(ver >> 8);
+        e.rec.info.ver_rev = (unsigned char)ver;
+        e.rec.info.tag_size = (uint)cell_number(&idx, tag_col, r);
+        e.rec.file_size = cell_number(&idx, size_col, r);
+        e.rec.mtime_ns = cell_number(&idx, mtime_col, r);
+        e.size = (off_t)e.rec.file_size;
+        e.mtime.tv_sec = (time_t)(e.rec.mtime_ns / 1000000000u);
+        e.mtime.tv_nsec = (long)(e.rec.mtime_ns % 1000000000u);
+        if (lib_insert(w, &e) != p_success)
+        {
+            free_tag_record(&e.rec);
+            break;
+        }
+        seeded++;
+    }
+    close_tag_index(&idx);
+    if (seeded)
+        printf("INFO: Resuming from %zu files in %s.\n", seeded, w->index_path);
+}
+
+static int cmp_str(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static Status write_index(Watcher *w)
+{
+    TagRecord *recs = malloc((w->count ? w->count : 1) * sizeof(TagRecord));
+    if (!recs)
+        return p_failure;
+    for (size_t i = 0; i < w->count; ++i)
+        recs[i] = w->entries[i].rec;
+
+    /* write beside the index and rename so readers never see a partial file */
+    char tmp_path[PATH_MAX];
+    Status st = p_failure;
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", w->index_path) < (int)sizeof(tmp_path) &&
+        write_tag_index(tmp_path, recs, w->count) == p_success &&
+        rename(tmp_path, w->index_path) == 0)
+        st = p_success;
+    free(recs);
+    return st;
+}
+
+/* Re-parse just the dirty files and rewrite the index */
+static void flush_dirty(Watcher *w, int force_write)
+{
+    size_t updated = 0, removed = 0;
+    if (w->ndirty)
+        qsort(w->dirty, w->ndirty, sizeof(char *), cmp_str);
+    for (size_t i = 0; i < w->ndirty; ++i)
+    {
+        const char *path = w->dirty[i];
+        if (i > 0 && strcmp(path, w->dirty[i - 1]) == 0)
+            continue;
+        long idx = lib_find(w, path);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            if (idx >= 0 && w->entries[idx].size == st.st_size &&
+                w->entries[idx].mtime.tv_sec == st.st_mtim.tv_sec &&
+                w->entries[idx].mtime.tv_nsec == st.st_mtim.tv_nsec)
+                continue;
+            WatchEntry e;
+            memset(&e, 0, sizeof(e));
+            if (load_tag_record(path, &e.rec) == p_success)
+            {
+                /* export the stamp compared here, so a restart agrees with it */
+                e.rec.file_size = (uint64_t)st.st_size;
+                e.rec.mtime_ns = (uint64_t)st.st_mtim.tv_sec * 1000000000u + (uint64_t)st.st_mtim.tv_nsec;
+                e.mtime = st.st_mtim;
+                e.size = st.st_size;
+                e.seen = w->gen;
+                if (idx >= 0)
+                    lib_remove(w, idx);
+                if (lib_insert(w, &e) != p_success)
+                    free_tag_record(&e.rec);
+                updated++;
+                continue;
+            }
+        }
+        /* gone or no longer a readable ID3 file */
+        if (idx >= 0)
+        {
+            lib_remove(w, idx);
+            removed++;
+        }
+    }
+    for (size_t i = 0; i < w->ndirty; ++i)
+        free(w->dirty[i]);
+    w->ndirty = 0;
+
+    if (!updated && !removed && !force_write)
+        return;
+    if (write_index(w) != p_success)
+    {
+        printf("❌ERROR: Unable to write index %s.\n", w->index_path);
+        return;
+    }
+    printf("INFO: Indexed %zu files (%zu updated, %zu removed).\n", w->count, updated, removed);
+    fflush(stdout);
+}
+
+static void handle_events(Watcher *w)
+{
+    char buf[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(w->ifd, buf, sizeof(buf))) > 0)
+    {
+        for (char *p = buf; p < buf + len;)
+        {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                /* directory creations may be among the lost events */
+                w->need_rescan = 1;
+                w->need_watches = 1;
+                continue;
+            }
+            if (ev->wd < 0 || ev->wd >= w->wd_cap || !w->wd_path[ev->wd])
+                continue;
+            if (ev->mask & IN_IGNORED)
+            {
+                free(w->wd_path[ev->wd]);
+                w->wd_path[ev->wd] = NULL;
+                continue;
+            }
+            if (ev->len == 0)
+                continue;
+
+            char path[PATH_MAX];
+            if (snprintf(path, sizeof(path), "%s/%s", w->wd_path[ev->wd], ev->name) >= (int)sizeof(path))
+                continue;
+            if (ev->mask & IN_ISDIR)
+            {
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+                    scan_dir(w, path, 1);
+                else
+                    w->need_rescan = 1; /* a directory left: let the scan drop its files */
+            }
+            else if (is_mp3_name(ev->name))
+                mark_dirty(w, path);
+        }
+    }
+}
+
+/* CLI: -w <music_dir> <index_file> -- runs until SIGINT/SIGTERM */
+Status watch_tags(char *argv[])
+{
+    if (argv[2] == NULL || argv[3] == NULL)
+    {
+        printf("➡️INFO: For Watching a library -> ./mp3_tag_reader -w <music_dir> <index_file>\n");
+        return p_failure;
+    }
+
+    Watcher w;
+    memset(&w, 0, sizeof(w));
+    w.root = argv[2];
+    w.index_path = argv[3];
+    w.ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w.ifd < 0)
+    {
+        printf("❌ERROR: inotify is not available.\n");
+        return p_failure;
+    }
+    if (lib_rehash(&w, 1024) != p_success)
+    {
+        close(w.ifd);
+        return p_failure;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    /* watches go in before the first scan so nothing slips between them */
+    seed_from_index(&w);
+    rescan(&w, 1);
+    flush_dirty(&w, 1);
+    printf("INFO: Watching %s (Ctrl+C to stop).\n", w.root);
+    fflush(stdout);
+
+    long long next_rescan = now_ms() + WATCH_RESCAN_SECS * 1000LL;
+    long long first_dirty = 0, last_event = 0;
+    size_t pending = 0;
+    while (!stop_requested)
+    {
+        long long now = now_ms();
+        long long wake = next_rescan;
+        if (w.ndirty)
+        {
+            long long debounce = last_event + WATCH_DEBOUNCE_MS;
+            long long cap = first_dirty + WATCH_MAX_DELAY_MS;
+            wake = debounce < cap ? debounce : cap;
+        }
+        int timeout = wake > now ? (int)(wake - now) : 0;
+
+        struct pollfd pfd = {w.ifd, POLLIN, 0};
+        int rc = poll(&pfd, 1, timeout);
+        if (rc < 0 && errno != EINTR)
+            break;
+        if (rc > 0)
+            handle_events(&w);
+
+        now = now_ms();
+        if (w.need_rescan || now >= next_rescan)
+        {
+            /* re-adding a watch to a watched directory is a no-op */
+            rescan(&w, w.need_watches);
+            next_rescan = now + WATCH_RESCAN_SECS * 1000LL;
+        }
+        if (w.ndirty != pending)
+        {
+            if (pending == 0)
+                first_dirty = now;
+            last_event = now;
+            pending = w.ndirty;
+        }
+        if (w.ndirty && (now - last_event >= WATCH_DEBOUNCE_MS || now - first_dirty >= WATCH_MAX_DELAY_MS))
+        {
+            flush_dirty(&w, 0);
+            pending = 0;
+        }
+    }
+
+    if (w.ndirty)
+        flush_dirty(&w, 0);
+    printf("INFO: Watch stopped.\n");
+
+    for (size_t i = 0; i < w.count; ++i)
+        free_tag_record(&w.entries[i].rec);
+    free(w.entries);
+    free(w.slots);
+    free(w.dirty);
+    for (int i = 0; i < w.wd_cap; ++i)
+        free(w.wd_path[i]);
+    free(w.wd_path);
+    close(w.ifd);
+    return p_success;
+}
@@ -0,0 +1,16 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "types.h"
+
+/* Quiet period after the last change event before re-parsing (absorbs the
+   write + rename burst of an edit) */
+#define WATCH_DEBOUNCE_MS 500
+/* Upper bound on how long a continuous burst may delay an index update */
+#define WATCH_MAX_DELAY_MS 5000
+/* Full mtime-diff scan to pick up anything the event stream missed */
+#define WATCH_RESCAN_SECS 600
+
+Status watch_tags (char* argv[]);
+
+#endif